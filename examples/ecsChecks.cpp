@@ -0,0 +1,481 @@
+#include <Saurobyte/World.hpp>
+#include <Saurobyte/Entity.hpp>
+#include <Saurobyte/System.hpp>
+#include <Saurobyte/Scene.hpp>
+#include <Saurobyte/Component.hpp>
+#include <Saurobyte/Archetype.hpp>
+#include <Saurobyte/SparseSet.hpp>
+#include <Saurobyte/CommandBuffer.hpp>
+#include <Saurobyte/MessageHandler.hpp>
+#include <Saurobyte/ConcurrentMessageQueue.hpp>
+#include <Saurobyte/Components/TransformComponent.hpp>
+#include <Saurobyte/Logger.hpp>
+#include <vector>
+#include <string>
+#include <memory>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+
+/*
+	Self-checking walkthrough of the entity and message machinery, run on a
+	headless World. Every scenario logs the checks that fail, and the program
+	exits with a non-zero status if any of them did.
+*/
+
+struct Health : public Saurobyte::Component<Health>
+{
+	int points;
+
+	explicit Health(int newPoints = 100) : points(newPoints) {};
+	virtual std::string getName() const { return "Health"; };
+};
+struct Armor : public Saurobyte::Component<Armor>
+{
+	int rating;
+
+	explicit Armor(int newRating = 0) : rating(newRating) {};
+	virtual std::string getName() const { return "Armor"; };
+};
+struct Poison : public Saurobyte::Component<Poison>
+{
+	int damage;
+
+	explicit Poison(int newDamage = 0) : damage(newDamage) {};
+	virtual std::string getName() const { return "Poison"; };
+
+	// Added and removed often, so kept out of the archetypes
+	static void reflect(Saurobyte::ComponentReflection<Poison> &reflection)
+	{
+		reflection.sparseStorage();
+	};
+};
+// Meant for SIMD loads, so stricter aligned than new guarantees
+struct alignas(64) Velocity : public Saurobyte::Component<Velocity>
+{
+	float values[4];
+
+	Velocity() : values() {};
+	virtual std::string getName() const { return "Velocity"; };
+};
+
+// Keeps queueing the same message from its handler, one more round every time
+class EchoHandler : public Saurobyte::MessageHandler
+{
+public:
+
+	int received;
+
+	explicit EchoHandler(Saurobyte::MessageCentral *central)
+		:
+		Saurobyte::MessageHandler(central),
+		received(0)
+	{
+		subscribe("Echo");
+	};
+
+	virtual void onMessage(const Saurobyte::Message &message)
+	{
+		received++;
+		queueMessage("Echo");
+	};
+	void stop()
+	{
+		unsubscribe("Echo");
+	};
+};
+
+// Wears down the armor of every entity each frame
+class WearSystem : public Saurobyte::System<WearSystem>
+{
+public:
+
+	explicit WearSystem(Saurobyte::World *world)
+		:
+		Saurobyte::System<WearSystem>(world)
+	{
+		addRequirement({Saurobyte::TypeIdGrabber::getUniqueTypeID<Armor>()});
+		addWriteAccess({Saurobyte::TypeIdGrabber::getUniqueTypeID<Armor>()});
+	};
+
+	virtual void processEntity(Saurobyte::Entity &entity)
+	{
+		entity.editComponent<Armor>()->rating--;
+	};
+};
+// Heals entities whose armor changed, without declaring that it reads the armor
+class RepairSystem : public Saurobyte::System<RepairSystem>
+{
+public:
+
+	int repaired;
+
+	explicit RepairSystem(Saurobyte::World *world)
+		:
+		Saurobyte::System<RepairSystem>(world),
+		repaired(0)
+	{
+		addRequirement({Saurobyte::TypeIdGrabber::getUniqueTypeID<Health>()});
+		addWriteAccess({Saurobyte::TypeIdGrabber::getUniqueTypeID<Health>()});
+		setChangeFilter({Saurobyte::TypeIdGrabber::getUniqueTypeID<Armor>()});
+	};
+
+	virtual void processEntity(Saurobyte::Entity &entity)
+	{
+		entity.getComponent<Health>()->points++;
+		repaired++;
+	};
+};
+// Heals entities whose armor changed a few at a time, taking its time on each of them
+class SlowRepairSystem : public Saurobyte::System<SlowRepairSystem>
+{
+public:
+
+	explicit SlowRepairSystem(Saurobyte::World *world)
+		:
+		Saurobyte::System<SlowRepairSystem>(world)
+	{
+		addRequirement({Saurobyte::TypeIdGrabber::getUniqueTypeID<Health>()});
+		addWriteAccess({Saurobyte::TypeIdGrabber::getUniqueTypeID<Health>()});
+		setChangeFilter({Saurobyte::TypeIdGrabber::getUniqueTypeID<Armor>()});
+		setTimeBudget(Saurobyte::milliseconds(1));
+	};
+
+	virtual void processEntity(Saurobyte::Entity &entity)
+	{
+		entity.getComponent<Health>()->points++;
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		while(std::chrono::steady_clock::now() - start < std::chrono::microseconds(250));
+	};
+};
+
+bool check(bool condition, const char *description)
+{
+	if(!condition)
+		SAUROBYTE_ERROR_LOG("Check failed: ", description);
+
+	return condition;
+}
+
+// Adding and removing components moves the entity between archetypes, keeping the values of the others
+bool checkArchetypeMoves(Saurobyte::World &world)
+{
+	Saurobyte::Entity &entity = world.createEntity();
+	entity.addComponent<Health>(50);
+	Saurobyte::Archetype *healthOnly = entity.getArchetype();
+
+	entity.addComponent<Armor>(3);
+	Saurobyte::Archetype *armored = entity.getArchetype();
+
+	bool passed = check(healthOnly != armored && armored->getEntityCount() == 1, "adding a component moves the entity");
+	passed &= check(entity.getComponent<Health>()->points == 50, "moved components keep their values");
+
+	entity.removeComponent<Armor>();
+	passed &= check(entity.getArchetype() == healthOnly && armored->getEntityCount() == 0, "removing a component moves it back");
+	passed &= check(entity.getComponent<Health>()->points == 50 && !entity.hasComponent<Armor>(), "only the removed component is gone");
+
+	entity.kill();
+	world.frame(0);
+	return passed;
+}
+
+// Columns and pooled components keep the alignment of their type, however strict
+bool checkOverAlignedComponents(Saurobyte::World &world)
+{
+	std::vector<Saurobyte::Entity*> entities;
+	for(int i = 0; i < 8; i++)
+	{
+		Saurobyte::Entity &entity = world.createEntity();
+		entity.addComponent<Health>();
+		entity.addComponent<Velocity>();
+		entities.push_back(&entity);
+	}
+
+	bool passed = true;
+	for(std::size_t i = 0; i < entities.size(); i++)
+	{
+		std::uintptr_t address = reinterpret_cast<std::uintptr_t>(entities[i]->getComponent<Velocity>());
+		passed &= check(address % alignof(Velocity) == 0, "over-aligned components are aligned within their chunk");
+		entities[i]->kill();
+	}
+
+	// Components created on their own are carved out of the slabs of their type's pool
+	std::unique_ptr<Velocity> detached(new Velocity());
+	passed &= check(reinterpret_cast<std::uintptr_t>(detached.get()) % alignof(Velocity) == 0, "pooled components are aligned within their slab");
+
+	world.frame(0);
+	return passed;
+}
+
+// Commands on the same component type replay into their final outcome, the last one wins
+bool checkCommandReplay(Saurobyte::World &world)
+{
+	Saurobyte::Entity &entity = world.createEntity();
+	Saurobyte::CommandBuffer commands;
+	{
+		Saurobyte::CommandBuffer::Scope scope(&commands);
+		entity.addComponent<Health>(1);
+		entity.removeComponent<Health>();
+		entity.addComponent<Health>(2);
+
+		entity.addComponent<Armor>(5);
+		entity.removeComponent<Armor>();
+	}
+
+	bool passed = check(!entity.hasComponent<Health>() && !commands.isEmpty(), "commands are recorded rather than executed");
+
+	commands.flush();
+	passed &= check(entity.hasComponent<Health>() && entity.getComponent<Health>()->points == 2, "the last add wins");
+	passed &= check(!entity.hasComponent<Armor>(), "a later remove cancels an add");
+	passed &= check(commands.isEmpty(), "flushing clears the buffer");
+
+	entity.kill();
+	world.frame(0);
+	return passed;
+}
+
+// Handles of killed entities stay invalid, even once their slot is reused
+bool checkHandleInvalidation(Saurobyte::World &world)
+{
+	Saurobyte::EntityPool &entityPool = world.getEntityPool();
+
+	Saurobyte::Entity &entity = world.createEntity();
+	Saurobyte::EntityHandle handle = entity.getHandle();
+	bool passed = check(entityPool.getEntity(handle) == &entity, "handles resolve to their entity");
+
+	entity.kill();
+	passed &= check(entityPool.isValid(handle), "killing is applied at the next frame");
+	world.frame(0);
+	passed &= check(!entityPool.isValid(handle) && entityPool.getEntity(handle) == nullptr, "handles of killed entities are invalid");
+
+	Saurobyte::Entity &reused = world.createEntity();
+	passed &= check(reused.getID() == handle.id && reused.getHandle() != handle, "reused slots get a new generation");
+	passed &= check(entityPool.getEntity(handle) == nullptr, "old handles don't resolve to the new entity");
+
+	reused.kill();
+	world.frame(0);
+	return passed;
+}
+
+// Removing a sparse component moves the last component of the set into its place
+bool checkSparseSwapRemove(Saurobyte::World &world)
+{
+	Saurobyte::SparseSet &poisoned = world.getEntityPool().getSparseSet<Poison>();
+	std::size_t initialSize = poisoned.getSize();
+
+	std::vector<Saurobyte::Entity*> entities;
+	for(int i = 0; i < 4; i++)
+	{
+		Saurobyte::Entity &entity = world.createEntity();
+		entity.addComponent<Poison>(i);
+		entities.push_back(&entity);
+	}
+
+	Saurobyte::Archetype *archetype = entities[1]->getArchetype();
+	entities[1]->removeComponent<Poison>();
+
+	bool passed = check(poisoned.getSize() == initialSize + 3 && !poisoned.contains(entities[1]->getID()), "removed components leave the set");
+	passed &= check(entities[1]->getArchetype() == archetype, "sparse components don't move the entity");
+	for(std::size_t i = 0; i < entities.size(); i++)
+	{
+		if(i != 1)
+			passed &= check(entities[i]->getComponent<Poison>()->damage == static_cast<int>(i), "the other components keep their owners");
+	}
+
+	for(std::size_t i = 0; i < entities.size(); i++)
+		entities[i]->kill();
+	world.frame(0);
+	return passed && check(poisoned.getSize() == initialSize, "killing entities empties the set");
+}
+
+// Change filters count as reads, so a system writing the filtered type never shares a stage with the filtering one
+bool checkChangeFilterOrdering()
+{
+	const int entityCount = 16;
+
+	Saurobyte::World world(2);
+	WearSystem *wear = new WearSystem(&world);
+	RepairSystem *repair = new RepairSystem(&world);
+	world.getSystemPool().addSystem(wear);
+	world.getSystemPool().addSystem(repair);
+
+	Saurobyte::Scene &scene = world.createScene("Repair");
+	for(int i = 0; i < entityCount; i++)
+	{
+		Saurobyte::Entity &entity = world.createEntity();
+		entity.addComponent<Health>();
+		entity.addComponent<Armor>(100);
+		scene.attach(entity);
+	}
+	world.changeScene("Repair");
+
+	bool passed = check(wear->conflictsWith(*repair), "filtered types are read by the filtering system");
+
+	// Every frame the writer runs first, and the filtering system sees all of its writes
+	for(int frame = 1; frame <= 4; frame++)
+	{
+		world.frame(0);
+		passed &= check(repair->repaired == frame * entityCount, "writes made earlier in the frame pass the change filter");
+	}
+
+	return passed;
+}
+
+// Time sliced systems keep reporting a change until the round-robin got around to the changed entity
+bool checkSlicedChangeFilter()
+{
+	const int entityCount = 16;
+
+	Saurobyte::World world;
+	SlowRepairSystem *repair = new SlowRepairSystem(&world);
+	world.getSystemPool().addSystem(repair);
+
+	Saurobyte::Scene &scene = world.createScene("SlowRepair");
+	std::vector<Saurobyte::Entity*> entities;
+	for(int i = 0; i < entityCount; i++)
+	{
+		Saurobyte::Entity &entity = world.createEntity();
+		entity.addComponent<Health>(0);
+		entity.addComponent<Armor>(100);
+		scene.attach(entity);
+		entities.push_back(&entity);
+	}
+	world.changeScene("SlowRepair");
+
+	// The first slice measures the cost per entity, after which only a few fit in the budget
+	world.frame(0);
+	for(std::size_t i = 0; i < entities.size(); i++)
+		entities[i]->editComponent<Armor>()->rating--;
+
+	for(int frame = 0; frame < 2 * entityCount; frame++)
+		world.frame(0);
+
+	bool passed = true;
+	for(std::size_t i = 0; i < entities.size(); i++)
+		passed &= check(entities[i]->getComponent<Health>()->points >= 2, "changes outside the current slice are not lost");
+
+	return passed;
+}
+
+// Names held in writable buffers are interned, so the ID outlives the buffer contents
+bool checkMessageIDNames()
+{
+	char buffer[16] = "Echo";
+	Saurobyte::MessageID id(buffer);
+	buffer[0] = '\0';
+
+	bool passed = check(id == Saurobyte::MessageID("Echo"), "buffers hash like the literal of the same name");
+	return passed && check(std::string(id.getName()) == "Echo", "the name is kept after the buffer changed");
+}
+
+// Messages queued while dispatching are sent in further rounds, up to SAUROBYTE_MAX_MESSAGE_ROUNDS per frame
+bool checkQueuedMessageRounds(Saurobyte::World &world)
+{
+	EchoHandler handler(&world.getMessageCentral());
+	world.queueMessage("Echo");
+	world.frame(0);
+
+	bool passed = check(handler.received == SAUROBYTE_MAX_MESSAGE_ROUNDS, "every round delivers the messages of the previous one");
+	passed &= check(world.getMessageCentral().getQueuedMessageCount() == 1, "the last round is left for the next frame");
+
+	world.frame(0);
+	passed &= check(handler.received == 2 * SAUROBYTE_MAX_MESSAGE_ROUNDS, "the cascade carries on the next frame");
+
+	handler.stop();
+	world.frame(0);
+	return passed && check(world.getMessageCentral().getQueuedMessageCount() == 0, "unsubscribing ends the cascade");
+}
+
+// The posted message queue refuses messages once full, and keeps its order as positions wrap around the slots
+bool checkPostedQueueWraparound()
+{
+	const std::size_t capacity = 8;
+	Saurobyte::ConcurrentMessageQueue queue(capacity);
+
+	int pushed = 0, popped = 0;
+	while(queue.push<Saurobyte::MessageData<int> >("Posted", pushed))
+		pushed++;
+
+	bool passed = check(pushed == static_cast<int>(queue.getCapacity()), "the queue holds its capacity");
+
+	for(int lap = 0; lap < 3; lap++)
+	{
+		// Free half the slots and fill them again, moving the positions around the slots
+		for(std::size_t i = 0; i < capacity / 2; i++)
+		{
+			Saurobyte::Message *message = queue.front();
+			passed &= check(message != nullptr && message->read<int>() == popped++, "messages come out in the order they were posted");
+			queue.pop();
+		}
+		while(queue.push<Saurobyte::MessageData<int> >("Posted", pushed))
+			pushed++;
+
+		passed &= check(pushed - popped == static_cast<int>(capacity), "freed slots are reused");
+	}
+
+	while(Saurobyte::Message *message = queue.front())
+	{
+		passed &= check(message->read<int>() == popped++, "the order holds after wrapping around");
+		queue.pop();
+	}
+
+	return passed && check(popped == pushed, "every posted message comes out");
+}
+
+// Entities moving across cells of the spatial grid are found in their new cell only
+bool checkGridCellMigration(Saurobyte::World &world)
+{
+	Saurobyte::SpatialGrid &grid = world.getSpatialGrid();
+	float cellSize = grid.getCellSize();
+
+	Saurobyte::Entity &entity = world.createEntity();
+	entity.addComponent<Saurobyte::TransformComponent>(cellSize * 0.5f, 0.f, 0.f);
+	world.frame(0);
+
+	std::size_t gridSize = grid.getSize();
+	std::vector<Saurobyte::Entity*> found;
+	grid.query(Saurobyte::Vector3f(cellSize * 0.5f, 0, 0), 1.f, found);
+	bool passed = check(found.size() == 1 && found[0] == &entity, "entities are found in their cell");
+
+	entity.getComponent<Saurobyte::TransformComponent>()->setPosition(cellSize * 10.5f, 0, 0);
+	world.frame(0);
+
+	found.clear();
+	grid.query(Saurobyte::Vector3f(cellSize * 0.5f, 0, 0), 1.f, found);
+	passed &= check(found.empty(), "entities leave their old cell");
+	grid.query(Saurobyte::Vector3f(cellSize * 10.5f, 0, 0), 1.f, found);
+	passed &= check(found.size() == 1 && found[0] == &entity, "entities are found in their new cell");
+	passed &= check(grid.getSize() == gridSize, "moving doesn't add entries");
+
+	found.clear();
+	grid.query(Saurobyte::Vector3f(0, 0, 0), std::numeric_limits<float>::infinity(), found);
+	passed &= check(found.size() == gridSize, "unbounded queries visit every occupied cell");
+
+	entity.kill();
+	world.frame(0);
+	return passed && check(grid.getSize() == gridSize - 1, "killed entities leave the grid");
+}
+
+int main(int argc, const char* argv[])
+{
+	Saurobyte::World world;
+
+	bool passed = true;
+	passed &= checkArchetypeMoves(world);
+	passed &= checkOverAlignedComponents(world);
+	passed &= checkCommandReplay(world);
+	passed &= checkHandleInvalidation(world);
+	passed &= checkSparseSwapRemove(world);
+	passed &= checkChangeFilterOrdering();
+	passed &= checkSlicedChangeFilter();
+	passed &= checkMessageIDNames();
+	passed &= checkQueuedMessageRounds(world);
+	passed &= checkPostedQueueWraparound();
+	passed &= checkGridCellMigration(world);
+
+	if(passed)
+		SAUROBYTE_INFO_LOG("All checks passed");
+
+	return passed ? 0 : 1;
+}
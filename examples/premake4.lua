@@ -29,3 +29,55 @@ solution(Saurobyte_Solution_Name)
 
 		configuration("Release")
 			flags({"Optimize"})
+
+	-- Set project options
+	project("systemBenchmark")
+		kind("ConsoleApp")
+		language("C++")
+		includedirs(Saurobyte_Example_IncDir)
+		libdirs(Saurobyte_Example_LibDir)
+		targetdir(".")
+
+		-- Set source files
+		files({"systemBenchmark.cpp"})
+
+		-- Link libraries per platform
+		links({"Saurobyte"})
+
+		-- Set rpath
+		configuration({"linux", "gmake"})
+			linkoptions("-Wl,-R\\$$ORIGIN/"..Saurobyte_Example_LibDir)
+		configuration("macosx", "gmake")
+			linkoptions("-Wl,-R@rpath/"..Saurobyte_Example_LibDir)
+
+		configuration("Debug")
+			flags({"Symbols"})
+
+		configuration("Release")
+			flags({"Optimize"})
+
+	-- Set project options
+	project("ecsChecks")
+		kind("ConsoleApp")
+		language("C++")
+		includedirs(Saurobyte_Example_IncDir)
+		libdirs(Saurobyte_Example_LibDir)
+		targetdir(".")
+
+		-- Set source files
+		files({"ecsChecks.cpp"})
+
+		-- Link libraries per platform
+		links({"Saurobyte"})
+
+		-- Set rpath
+		configuration({"linux", "gmake"})
+			linkoptions("-Wl,-R\\$$ORIGIN/"..Saurobyte_Example_LibDir)
+		configuration("macosx", "gmake")
+			linkoptions("-Wl,-R@rpath/"..Saurobyte_Example_LibDir)
+
+		configuration("Debug")
+			flags({"Symbols"})
+
+		configuration("Release")
+			flags({"Optimize"})
@@ -0,0 +1,154 @@
+#include <Saurobyte/Engine.hpp>
+#include <Saurobyte/System.hpp>
+#include <Saurobyte/Component.hpp>
+#include <Saurobyte/Entity.hpp>
+#include <Saurobyte/Logger.hpp>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+/*
+	Synthetic workloads measuring how frame times scale with the amount of
+	worker threads used by SystemPool::processSystems.
+
+	Every system writes its own component and reads a shared one, so all
+	systems are independent and may run in parallel. The second run only
+	keeps a single system, which splits its entities into parallel chunks.
+*/
+
+const std::size_t EntityCount = 20000;
+const std::size_t FrameCount = 60;
+
+struct SharedData : public Saurobyte::Component<SharedData>
+{
+	float seed;
+
+	explicit SharedData(float newSeed) : seed(newSeed) {};
+	virtual std::string getName() const { return "SharedData"; };
+};
+
+template<int TIndex> struct Payload : public Saurobyte::Component<Payload<TIndex> >
+{
+	float value;
+
+	Payload() : value(0) {};
+	virtual std::string getName() const { return "Payload"; };
+};
+
+template<int TIndex> class BusySystem : public Saurobyte::System<BusySystem<TIndex> >
+{
+public:
+
+	explicit BusySystem(Saurobyte::Engine *engine)
+		:
+		Saurobyte::System<BusySystem<TIndex> >(engine)
+	{
+		this->addRequirement({
+			Saurobyte::TypeIdGrabber::getUniqueTypeID<SharedData>(),
+			Saurobyte::TypeIdGrabber::getUniqueTypeID<Payload<TIndex> >()});
+		this->addReadAccess({Saurobyte::TypeIdGrabber::getUniqueTypeID<SharedData>()});
+		this->addWriteAccess({Saurobyte::TypeIdGrabber::getUniqueTypeID<Payload<TIndex> >()});
+	};
+
+	virtual void processEntity(Saurobyte::Entity &entity)
+	{
+		float seed = entity.getComponent<SharedData>()->seed;
+		Payload<TIndex> *payload = entity.getComponent<Payload<TIndex> >();
+
+		// Some busy work
+		for(int i = 0; i < 32; i++)
+			payload->value += std::sin(seed * (i + TIndex));
+	};
+};
+
+template<int TIndex> void addPayload(Saurobyte::Entity &entity)
+{
+	entity.addComponent<Payload<TIndex> >();
+}
+
+void measureFrameTime(Saurobyte::SystemPool &systemPool)
+{
+	typedef std::chrono::high_resolution_clock FrameClock;
+	std::size_t maxWorkers = std::thread::hardware_concurrency();
+	float singleThreadTime = 0;
+
+	for(std::size_t workers = 0; workers < std::max<std::size_t>(maxWorkers, 1); workers++)
+	{
+		systemPool.setWorkerCount(workers);
+		systemPool.processSystems(); // Warm up
+
+		FrameClock::time_point start = FrameClock::now();
+		for(std::size_t frame = 0; frame < FrameCount; frame++)
+			systemPool.processSystems();
+		FrameClock::time_point end = FrameClock::now();
+
+		float frameTime = std::chrono::duration_cast<std::chrono::duration<float, std::milli> >(end - start).count() / FrameCount;
+		if(workers == 0)
+			singleThreadTime = frameTime;
+
+		SAUROBYTE_INFO_LOG(
+			"Threads: ", workers + 1,
+			" Frame time: ", frameTime, " ms",
+			" Speedup: ", singleThreadTime / frameTime, "x");
+	}
+}
+
+int main(int argc, const char* argv[])
+{
+	Saurobyte::Engine engine("System benchmark", 320, 240);
+	Saurobyte::SystemPool &systemPool = engine.getSystemPool();
+
+	systemPool.addSystem(new BusySystem<0>(&engine));
+	systemPool.addSystem(new BusySystem<1>(&engine));
+	systemPool.addSystem(new BusySystem<2>(&engine));
+	systemPool.addSystem(new BusySystem<3>(&engine));
+	systemPool.addSystem(new BusySystem<4>(&engine));
+	systemPool.addSystem(new BusySystem<5>(&engine));
+	systemPool.addSystem(new BusySystem<6>(&engine));
+	systemPool.addSystem(new BusySystem<7>(&engine));
+
+	const Saurobyte::TypeID systemTypes[] =
+	{
+		Saurobyte::TypeIdGrabber::getUniqueTypeID<BusySystem<0> >(),
+		Saurobyte::TypeIdGrabber::getUniqueTypeID<BusySystem<1> >(),
+		Saurobyte::TypeIdGrabber::getUniqueTypeID<BusySystem<2> >(),
+		Saurobyte::TypeIdGrabber::getUniqueTypeID<BusySystem<3> >(),
+		Saurobyte::TypeIdGrabber::getUniqueTypeID<BusySystem<4> >(),
+		Saurobyte::TypeIdGrabber::getUniqueTypeID<BusySystem<5> >(),
+		Saurobyte::TypeIdGrabber::getUniqueTypeID<BusySystem<6> >(),
+		Saurobyte::TypeIdGrabber::getUniqueTypeID<BusySystem<7> >()
+	};
+
+	Saurobyte::Scene &scene = engine.createScene("Benchmark");
+	for(std::size_t i = 0; i < EntityCount; i++)
+	{
+		Saurobyte::Entity &entity = engine.createEntity();
+		entity.addComponent<SharedData>(static_cast<float>(i));
+		addPayload<0>(entity);
+		addPayload<1>(entity);
+		addPayload<2>(entity);
+		addPayload<3>(entity);
+		addPayload<4>(entity);
+		addPayload<5>(entity);
+		addPayload<6>(entity);
+		addPayload<7>(entity);
+		scene.attach(entity);
+	}
+
+	// Attach the entities to the systems
+	engine.getScenePool().frameCleanup();
+	engine.getEntityPool().frameCleanup();
+
+	SAUROBYTE_INFO_LOG("Independent systems");
+	measureFrameTime(systemPool);
+
+	// A single heavy system, split into chunks instead
+	for(std::size_t i = 1; i < 8; i++)
+		systemPool.getSystem(systemTypes[i])->setActive(false);
+	systemPool.getSystem(systemTypes[0])->setParallelProcessing(true);
+
+	SAUROBYTE_INFO_LOG("Single parallel system");
+	measureFrameTime(systemPool);
+
+	return 0;
+}
@@ -29,7 +29,7 @@ Saurobyte_Dep_SourceDir = "dependencies/src/"
 -- Libraries to link against
 Saurobyte_Linux_Links =
 {
-	"GL", "GLEW", "SDL2", "SDL2_image", "lua", "openal", "sndfile"
+	"GL", "GLEW", "SDL2", "SDL2_image", "lua", "openal", "sndfile", "pthread"
 }
 Saurobyte_Linux_Static_Links =
 {
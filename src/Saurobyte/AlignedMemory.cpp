@@ -0,0 +1,64 @@
+/*
+
+	The MIT License (MIT)
+
+	Copyright (c) 2014 by Jakob Larsson
+
+	Permission is hereby granted, free of charge, to any person obtaining 
+	a copy of this software and associated documentation files (the "Software"), 
+	to deal in the Software without restriction, including without limitation the 
+	rights to use, copy, modify, merge, publish, distribute, sublicense, and/or 
+	sell copies of the Software, and to permit persons to whom the Software is 
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in 
+	all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+	IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+#include <Saurobyte/AlignedMemory.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
+
+namespace Saurobyte
+{
+	void AlignedDeleter::operator()(unsigned char *memory) const
+	{
+#if defined(_WIN32)
+		_aligned_free(memory);
+#else
+		std::free(memory);
+#endif
+	}
+
+	AlignedBuffer allocateAligned(std::size_t size, std::size_t alignment)
+	{
+		// posix_memalign wants at least pointer alignment, and never give out less than new would
+		alignment = std::max(alignment, alignof(std::max_align_t));
+
+		void *memory = nullptr;
+#if defined(_WIN32)
+		memory = _aligned_malloc(std::max<std::size_t>(size, 1), alignment);
+#else
+		if(posix_memalign(&memory, alignment, std::max<std::size_t>(size, 1)) != 0)
+			memory = nullptr;
+#endif
+
+		if(memory == nullptr)
+			throw std::bad_alloc();
+
+		return AlignedBuffer(static_cast<unsigned char*>(memory));
+	}
+};
@@ -0,0 +1,50 @@
+/*
+
+	The MIT License (MIT)
+
+	Copyright (c) 2014 by Jakob Larsson
+
+	Permission is hereby granted, free of charge, to any person obtaining 
+	a copy of this software and associated documentation files (the "Software"), 
+	to deal in the Software without restriction, including without limitation the 
+	rights to use, copy, modify, merge, publish, distribute, sublicense, and/or 
+	sell copies of the Software, and to permit persons to whom the Software is 
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in 
+	all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+	IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+#ifndef SAUROBYTE_ALIGNED_MEMORY_HPP
+#define SAUROBYTE_ALIGNED_MEMORY_HPP
+
+#include <memory>
+#include <cstddef>
+
+namespace Saurobyte
+{
+	// Releases memory retrieved through allocateAligned
+	struct AlignedDeleter
+	{
+		void operator()(unsigned char *memory) const;
+	};
+	typedef std::unique_ptr<unsigned char[], AlignedDeleter> AlignedBuffer;
+
+	/**
+	 * Allocates raw memory aligned for types with stricter alignment than new provides
+	 * @param  size      Amount of bytes to allocate
+	 * @param  alignment Required alignment, a power of two
+	 * @return           The memory, never nullptr
+	 */
+	AlignedBuffer allocateAligned(std::size_t size, std::size_t alignment);
+};
+
+#endif
@@ -0,0 +1,267 @@
+/*
+
+	The MIT License (MIT)
+
+	Copyright (c) 2014 by Jakob Larsson
+
+	Permission is hereby granted, free of charge, to any person obtaining
+	a copy of this software and associated documentation files (the "Software"),
+	to deal in the Software without restriction, including without limitation the
+	rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+	sell copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in
+	all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+	IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+#include <Saurobyte/Archetype.hpp>
+#include <Saurobyte/Entity.hpp>
+#include <Saurobyte/Component.hpp>
+#include <algorithm>
+#include <cstddef>
+
+namespace Saurobyte
+{
+	namespace
+	{
+		std::size_t alignOffset(std::size_t offset, std::size_t alignment)
+		{
+			return (offset + alignment - 1) / alignment * alignment;
+		}
+	};
+
+	Archetype::Archetype(const std::vector<const ComponentType*> &componentTypes)
+		:
+		m_componentTypes(componentTypes),
+		m_chunkCapacity(1),
+		m_chunkAlignment(alignof(std::max_align_t))
+	{
+		// Keep columns sorted by type so equal component sets yield equal archetypes
+		std::sort(m_componentTypes.begin(), m_componentTypes.end(),
+			[] (const ComponentType *lhs, const ComponentType *rhs) { return lhs->id < rhs->id; });
+
+		std::fill(m_columnLookup, m_columnLookup + SAUROBYTE_MAX_COMPONENT_TYPES, -1);
+
+		std::size_t rowSize = 0;
+		std::size_t paddingSize = 0;
+		for(std::size_t i = 0; i < m_componentTypes.size(); i++)
+		{
+			const ComponentType *type = m_componentTypes[i];
+			m_signature.push_back(type->id);
+			m_signatureMask.set(type->signatureBit);
+			m_columnLookup[type->signatureBit] = static_cast<int>(i);
+			rowSize += type->size;
+			paddingSize += type->alignment;
+			m_chunkAlignment = std::max(m_chunkAlignment, type->alignment);
+		}
+
+		// Fit as many rows as possible into a chunk, leaving room for column alignment
+		if(rowSize > 0 && paddingSize < ChunkSize)
+			m_chunkCapacity = std::max<std::size_t>(1, (ChunkSize - paddingSize) / rowSize);
+
+		std::size_t offset = 0;
+		for(std::size_t i = 0; i < m_componentTypes.size(); i++)
+		{
+			offset = alignOffset(offset, m_componentTypes[i]->alignment);
+			m_columnOffsets.push_back(offset);
+			offset += m_componentTypes[i]->size * m_chunkCapacity;
+		}
+	}
+	Archetype::~Archetype()
+	{
+		// Destroy remaining components, back to front so no rows are moved
+		while(!m_entities.empty())
+			removeRow(m_entities.size() - 1);
+	}
+
+	std::size_t Archetype::allocateRow(Entity &entity)
+	{
+		std::size_t row = m_entities.size();
+
+		// Grab a new chunk if the current ones are full
+		if(row / m_chunkCapacity >= m_chunks.size())
+			m_chunks.push_back(allocateAligned(getChunkBytes(), m_chunkAlignment));
+
+		m_entities.push_back(&entity);
+		return row;
+	}
+	void Archetype::reserve(std::size_t rowCount)
+	{
+		m_entities.reserve(rowCount);
+
+		while(m_chunks.size() * m_chunkCapacity < rowCount)
+			m_chunks.push_back(allocateAligned(getChunkBytes(), m_chunkAlignment));
+	}
+	void Archetype::fillRows(std::size_t firstRow, std::size_t rowCount, const BaseComponent &component)
+	{
+		int column = getColumnIndex(component.getTypeID());
+		const ComponentType *type = m_componentTypes[column];
+
+		// Rows are only contiguous within a chunk, so fill chunk by chunk
+		std::size_t row = firstRow, endRow = firstRow + rowCount;
+		while(row < endRow)
+		{
+			std::size_t count = std::min(endRow - row, m_chunkCapacity - row % m_chunkCapacity);
+			type->copyConstructRange(getData(row, column), component, count);
+			row += count;
+		}
+	}
+	void Archetype::writeSnapshot(TypeID id, std::vector<unsigned char> &buffer)
+	{
+		int column = getColumnIndex(id);
+		const ComponentType *type = m_componentTypes[column];
+
+		std::size_t offset = buffer.size();
+		buffer.resize(offset + type->serializedSize * m_entities.size());
+		for(std::size_t row = 0; row < m_entities.size(); row++)
+		{
+			type->writeFields(getData(row, column), buffer.data() + offset);
+			offset += type->serializedSize;
+		}
+	}
+	std::size_t Archetype::readSnapshot(TypeID id, const unsigned char *data)
+	{
+		int column = getColumnIndex(id);
+		const ComponentType *type = m_componentTypes[column];
+
+		for(std::size_t row = 0; row < m_entities.size(); row++)
+			type->readFields(getData(row, column), data + row * type->serializedSize);
+
+		return type->serializedSize * m_entities.size();
+	}
+	std::size_t Archetype::getChunkBytes() const
+	{
+		return m_columnOffsets.empty() ? 0 :
+			m_columnOffsets.back() + m_componentTypes.back()->size * m_chunkCapacity;
+	}
+	void Archetype::removeRow(std::size_t row)
+	{
+		for(std::size_t i = 0; i < m_componentTypes.size(); i++)
+			m_componentTypes[i]->destroy(getData(row, i));
+
+		releaseRow(row);
+	}
+	std::size_t Archetype::moveRow(std::size_t row, Archetype &target)
+	{
+		std::size_t targetRow = target.allocateRow(*m_entities[row]);
+
+		for(std::size_t i = 0; i < m_componentTypes.size(); i++)
+		{
+			const ComponentType *type = m_componentTypes[i];
+			int targetColumn = target.getColumnIndex(type->id);
+
+			if(targetColumn >= 0)
+				type->moveConstruct(target.getData(targetRow, targetColumn), getData(row, i));
+
+			type->destroy(getData(row, i));
+		}
+
+		releaseRow(row);
+		return targetRow;
+	}
+
+	void Archetype::releaseRow(std::size_t row)
+	{
+		// Fill the gap with the last row to keep the columns packed
+		std::size_t lastRow = m_entities.size() - 1;
+		if(row != lastRow)
+		{
+			for(std::size_t i = 0; i < m_componentTypes.size(); i++)
+			{
+				m_componentTypes[i]->moveConstruct(getData(row, i), getData(lastRow, i));
+				m_componentTypes[i]->destroy(getData(lastRow, i));
+			}
+
+			m_entities[row] = m_entities[lastRow];
+			m_entities[row]->m_row = row;
+		}
+
+		m_entities.pop_back();
+	}
+
+	unsigned char* Archetype::getData(std::size_t row, std::size_t column)
+	{
+		return m_chunks[row / m_chunkCapacity].get() +
+			m_columnOffsets[column] +
+			(row % m_chunkCapacity) * m_componentTypes[column]->size;
+	}
+	void* Archetype::getComponentData(std::size_t row, TypeID id)
+	{
+		int column = getColumnIndex(id);
+		return column < 0 ? nullptr : getData(row, column);
+	}
+	BaseComponent* Archetype::getComponent(std::size_t row, TypeID id)
+	{
+		int column = getColumnIndex(id);
+		return column < 0 ? nullptr : m_componentTypes[column]->toBase(getData(row, column));
+	}
+
+	Entity* const* Archetype::getChunkEntities(std::size_t chunk) const
+	{
+		return m_entities.data() + chunk * m_chunkCapacity;
+	}
+	Entity& Archetype::getEntity(std::size_t row) const
+	{
+		return *m_entities[row];
+	}
+	std::size_t Archetype::getChunkCount() const
+	{
+		// Chunks are kept allocated when emptied, only count those in use
+		return (m_entities.size() + m_chunkCapacity - 1) / m_chunkCapacity;
+	}
+	std::size_t Archetype::getChunkEntityCount(std::size_t chunk) const
+	{
+		return std::min(m_chunkCapacity, m_entities.size() - chunk * m_chunkCapacity);
+	}
+	std::size_t Archetype::getChunkCapacity() const
+	{
+		return m_chunkCapacity;
+	}
+
+	int Archetype::getColumnIndex(TypeID id) const
+	{
+		// Types that were never registered can't be part of any archetype
+		const ComponentType *type = ComponentType::get(id);
+		return type ? m_columnLookup[type->signatureBit] : -1;
+	}
+	bool Archetype::hasComponent(TypeID id) const
+	{
+		return getColumnIndex(id) >= 0;
+	}
+	bool Archetype::hasComponents(const std::vector<TypeID> &ids) const
+	{
+		for(std::size_t i = 0; i < ids.size(); i++)
+		{
+			if(!hasComponent(ids[i]))
+				return false;
+		}
+
+		return true;
+	}
+
+	const Archetype::Signature& Archetype::getSignature() const
+	{
+		return m_signature;
+	}
+	const ComponentSignature& Archetype::getSignatureMask() const
+	{
+		return m_signatureMask;
+	}
+	const std::vector<const ComponentType*>& Archetype::getComponentTypes() const
+	{
+		return m_componentTypes;
+	}
+	std::size_t Archetype::getEntityCount() const
+	{
+		return m_entities.size();
+	}
+};
@@ -0,0 +1,218 @@
+/*
+
+	The MIT License (MIT)
+
+	Copyright (c) 2014 by Jakob Larsson
+
+	Permission is hereby granted, free of charge, to any person obtaining
+	a copy of this software and associated documentation files (the "Software"),
+	to deal in the Software without restriction, including without limitation the
+	rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+	sell copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in
+	all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+	IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+#ifndef SAUROBYTE_ARCHETYPE_HPP
+#define SAUROBYTE_ARCHETYPE_HPP
+
+#include <Saurobyte/IdentifierTypes.hpp>
+#include <Saurobyte/ComponentType.hpp>
+#include <Saurobyte/NonCopyable.hpp>
+#include <Saurobyte/AlignedMemory.hpp>
+#include <unordered_map>
+#include <vector>
+#include <memory>
+
+namespace Saurobyte
+{
+	class Entity;
+	class BaseComponent;
+
+	/*
+		Archetype
+
+		Storage for all entities sharing the exact same set of component types.
+		Components are stored by value in fixed size chunks, where every chunk
+		holds one contiguous array (column) per component type. Entities with
+		the same components are thus tightly packed, and a column can be
+		iterated linearly:
+
+			for(std::size_t c = 0; c < archetype.getChunkCount(); c++)
+			{
+				TransformComponent *transforms = archetype.getColumn<TransformComponent>(c);
+				for(std::size_t i = 0; i < archetype.getChunkEntityCount(c); i++)
+					transforms[i].move(1, 0, 0);
+			}
+
+		Removing an entity moves the last entity of the archetype into its row,
+		so pointers to components are only valid until the next structural
+		change (adding or removing components, killing entities).
+
+	*/
+	class Archetype : public NonCopyable
+	{
+	public:
+
+		// Component type identifiers, sorted in ascending order
+		typedef std::vector<TypeID> Signature;
+
+		// Size in bytes of a single chunk of component memory
+		static const std::size_t ChunkSize = 16 * 1024;
+
+		explicit Archetype(const std::vector<const ComponentType*> &componentTypes);
+		~Archetype();
+
+		/**
+		 * Allocates a row at the end of the archetype for the specified entity, the components of the row are left unconstructed
+		 * @param  entity The entity that will own the row
+		 * @return        The index of the new row
+		 */
+		std::size_t allocateRow(Entity &entity);
+
+		/**
+		 * Makes sure the archetype can hold the specified amount of rows without allocating chunks
+		 * @param rowCount The total amount of rows
+		 */
+		void reserve(std::size_t rowCount);
+
+		/**
+		 * Copy constructs a component into a range of rows, the components of the range must be unconstructed
+		 * @param firstRow  The first row of the range
+		 * @param rowCount  Amount of rows in the range
+		 * @param component The component to copy, its type must be part of the archetype
+		 */
+		void fillRows(std::size_t firstRow, std::size_t rowCount, const BaseComponent &component);
+
+		/**
+		 * Appends the reflected fields (see ComponentReflection) of one component type to a buffer, for every
+		 * row in order. Component types without reflected fields write nothing.
+		 * @param id     The component type, which must be part of the archetype
+		 * @param buffer The buffer to append to
+		 */
+		void writeSnapshot(TypeID id, std::vector<unsigned char> &buffer);
+		/**
+		 * Restores the reflected fields of one component type from a snapshot taken by writeSnapshot, the
+		 * archetype must hold the same rows as when the snapshot was taken
+		 * @param  id   The component type, which must be part of the archetype
+		 * @param  data The snapshot data
+		 * @return      The amount of bytes read
+		 */
+		std::size_t readSnapshot(TypeID id, const unsigned char *data);
+
+		/**
+		 * Destroys the components of a row and releases it, the last row in the archetype is moved into its place
+		 * @param row The row to remove
+		 */
+		void removeRow(std::size_t row);
+
+		/**
+		 * Moves a row into another archetype. Components shared by both archetypes are moved, components missing
+		 * in the target are destroyed and components missing in this archetype are left unconstructed.
+		 * @param  row    The row to move
+		 * @param  target The archetype to move the row to
+		 * @return        The index of the row in the target archetype
+		 */
+		std::size_t moveRow(std::size_t row, Archetype &target);
+
+		/**
+		 * Retrieves the raw storage of a component
+		 * @param  row The row of the entity
+		 * @param  id  The type of the component
+		 * @return     Pointer to the component memory, or nullptr if the archetype lacks the component type
+		 */
+		void* getComponentData(std::size_t row, TypeID id);
+		BaseComponent* getComponent(std::size_t row, TypeID id);
+
+		/**
+		 * Retrieves the component column of a chunk, the column holds getChunkEntityCount(chunk) components
+		 * @param  chunk Index of the chunk
+		 * @return       Pointer to the first component in the chunk, or nullptr if the archetype lacks the component type
+		 */
+		template<typename TType> TType* getColumn(std::size_t chunk)
+		{
+			int column = m_columnLookup[ComponentType::get<TType>().signatureBit];
+			if(column < 0)
+				return nullptr;
+
+			return reinterpret_cast<TType*>(m_chunks[chunk].get() + m_columnOffsets[column]);
+		};
+
+		/**
+		 * Retrieves the entities owning the rows of a chunk, in the same order as the component columns
+		 * @param  chunk Index of the chunk
+		 * @return       Pointer to the first entity in the chunk
+		 */
+		Entity* const* getChunkEntities(std::size_t chunk) const;
+		// Retrieves the entity owning a row
+		Entity& getEntity(std::size_t row) const;
+
+		std::size_t getChunkCount() const;
+		std::size_t getChunkEntityCount(std::size_t chunk) const;
+		std::size_t getChunkCapacity() const;
+
+		/**
+		 * Returns the column of the specified component type, or -1 if the archetype lacks it
+		 */
+		int getColumnIndex(TypeID id) const;
+		bool hasComponent(TypeID id) const;
+
+		/**
+		 * Returns whether or not this archetype has all of the specified component types
+		 */
+		bool hasComponents(const std::vector<TypeID> &ids) const;
+
+		const Signature& getSignature() const;
+		// Bitset form of the signature, for fast subset tests
+		const ComponentSignature& getSignatureMask() const;
+		const std::vector<const ComponentType*>& getComponentTypes() const;
+
+		std::size_t getEntityCount() const;
+
+	private:
+
+		friend class EntityPool;
+
+		typedef AlignedBuffer ChunkPtr;
+
+		Signature m_signature;
+		ComponentSignature m_signatureMask;
+		std::vector<const ComponentType*> m_componentTypes;
+
+		// Offset of every column from the start of a chunk
+		std::vector<std::size_t> m_columnOffsets;
+
+		// Column of every component type indexed by its signature bit, -1 if the archetype lacks it
+		int m_columnLookup[SAUROBYTE_MAX_COMPONENT_TYPES];
+
+		// Chunks are aligned for the most strictly aligned column
+		std::size_t m_chunkCapacity;
+		std::size_t m_chunkAlignment;
+		std::vector<ChunkPtr> m_chunks;
+
+		// The owner of every row
+		std::vector<Entity*> m_entities;
+
+		// Cached archetype transitions when adding or removing a component type
+		std::unordered_map<TypeID, Archetype*> m_addEdges;
+		std::unordered_map<TypeID, Archetype*> m_removeEdges;
+
+		// Releases a row whose components have already been destroyed or moved
+		void releaseRow(std::size_t row);
+
+		unsigned char* getData(std::size_t row, std::size_t column);
+		std::size_t getChunkBytes() const;
+	};
+};
+
+#endif
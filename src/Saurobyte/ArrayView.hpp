@@ -0,0 +1,88 @@
+/*
+
+	The MIT License (MIT)
+
+	Copyright (c) 2014 by Jakob Larsson
+
+	Permission is hereby granted, free of charge, to any person obtaining 
+	a copy of this software and associated documentation files (the "Software"), 
+	to deal in the Software without restriction, including without limitation the 
+	rights to use, copy, modify, merge, publish, distribute, sublicense, and/or 
+	sell copies of the Software, and to permit persons to whom the Software is 
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in 
+	all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+	IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+#ifndef SAUROBYTE_ARRAYVIEW_HPP
+#define SAUROBYTE_ARRAYVIEW_HPP
+
+#include <cstddef>
+
+namespace Saurobyte
+{
+	/*
+		ArrayView
+
+		Read-only, non-owning view of a contiguous range of elements. Cheap to
+		copy and iterable with range-based for loops. The view is invalidated
+		when the underlying storage is modified.
+
+	*/
+	template<typename TType> class ArrayView
+	{
+	public:
+
+		typedef const TType* const_iterator;
+
+		ArrayView()
+			:
+			m_begin(nullptr),
+			m_size(0)
+		{};
+		ArrayView(const TType *begin, std::size_t size)
+			:
+			m_begin(begin),
+			m_size(size)
+		{};
+
+		const_iterator begin() const
+		{
+			return m_begin;
+		};
+		const_iterator end() const
+		{
+			return m_begin + m_size;
+		};
+
+		const TType& operator[] (std::size_t index) const
+		{
+			return m_begin[index];
+		};
+
+		std::size_t size() const
+		{
+			return m_size;
+		};
+		bool empty() const
+		{
+			return m_size == 0;
+		};
+
+	private:
+
+		const TType *m_begin;
+		std::size_t m_size;
+	};
+};
+
+#endif
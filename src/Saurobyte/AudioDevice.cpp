@@ -6,6 +6,7 @@
 #include <Saurobyte/OpenALImpl.hpp>
 #include <Saurobyte/AudioFileImpl.hpp>
 #include <Saurobyte/Util.hpp>
+#include <Saurobyte/MessageCentral.hpp>
 
 #include <unordered_map>
 #include <string>
@@ -14,6 +15,7 @@
 #include <limits>
 #include <sstream>
 #include <algorithm>
+#include <atomic>
 
 namespace Saurobyte
 {
@@ -27,6 +29,9 @@ namespace Saurobyte
 		// Active audio sources
 		std::vector<SoundData> m_sounds;
 
+		// Central of the engine owning the device, read by streaming threads
+		std::atomic<MessageCentral*> m_messageCentral(nullptr);
+
 		// Sounds can be played through channels which allows their volume
 		// to be set collectively. TODO
 		//std::unordered_map<std::string, float> m_audioChannels;
@@ -34,15 +39,23 @@ namespace Saurobyte
 	};
 
 
-	AudioDevice::AudioDevice()
+	AudioDevice::AudioDevice(MessageCentral &messageCentral)
 		:
 		m_openAL(new internal::OpenALImpl())
 	{
-
+		m_messageCentral = &messageCentral;
 	}
 	AudioDevice::~AudioDevice()
 	{
+		// Streaming threads may be posting to the central, so they have to finish before it goes away
+		for(std::size_t i = 0; i < m_sounds.size(); i++)
+		{
+			AudioStream *stream = dynamic_cast<AudioStream*>(m_sounds[i].second.get());
+			if(stream != nullptr)
+				stream->stopStreaming();
+		}
 
+		m_messageCentral = nullptr;
 	}
 
 	void AudioDevice::registerAudio(const std::string &fileName, const std::string &name)
@@ -170,6 +183,12 @@ namespace Saurobyte
 
 	}
 
+	bool AudioDevice::postMessage(const MessageID &messageID, std::uint32_t source)
+	{
+		MessageCentral *messageCentral = m_messageCentral;
+		return messageCentral != nullptr && messageCentral->postMessage<std::uint32_t>(messageID, source);
+	}
+
 	std::uint32_t AudioDevice::grabAudioSource()
 	{
 		std::uint32_t newSource = 0;
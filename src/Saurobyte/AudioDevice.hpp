@@ -43,6 +43,8 @@ namespace Saurobyte
 	{
 		class OpenALImpl;
 	};
+	class MessageCentral;
+	class MessageID;
 
 	class AudioDevice
 	{
@@ -98,9 +100,15 @@ namespace Saurobyte
 		// Only the Engine can create an AudioDevice
 		friend class Engine;
 
+		// Streams post messages from their streaming threads
+		friend class AudioStream;
+
 		std::unique_ptr<internal::OpenALImpl> m_openAL;
 
-		AudioDevice();
+		AudioDevice(MessageCentral &messageCentral);
+
+		// Posts a message with the OpenAL source of a sound as data to the engine, may be called from any thread
+		static bool postMessage(const MessageID &messageID, std::uint32_t source);
 
 		// Deleletes unused audio memory, TODO
 		static void bufferCleanup();
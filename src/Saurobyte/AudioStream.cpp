@@ -25,6 +25,8 @@
 
 
 #include <Saurobyte/AudioStream.hpp>
+#include <Saurobyte/AudioDevice.hpp>
+#include <Saurobyte/Message.hpp>
 #include <Saurobyte/AudioFileImpl.hpp>
 #include <Saurobyte/Util.hpp>
 #include <al.h>
@@ -46,10 +48,7 @@ namespace Saurobyte
 	AudioStream::~AudioStream()
 	{
 		// Make sure to stop the streaming thread
-		m_requestStop = true;
-
-		if(m_thread.joinable())
-			m_thread.join();
+		stopStreaming();
 	}
 
 	void AudioStream::play()
@@ -80,10 +79,7 @@ namespace Saurobyte
 		{
 			// Reset offset and stop the OpenAL source
 			m_playingOffset = Time();
-			m_requestStop = true;
-
-			if(m_thread.joinable())
-				m_thread.join();
+			stopStreaming();
 
 			alSourceStop(m_source); // TODO this was previously above the thread joining, check if better
 			m_file->setReadingOffset(0);
@@ -108,6 +104,14 @@ namespace Saurobyte
 		}
 	}
 
+	void AudioStream::stopStreaming()
+	{
+		m_requestStop = true;
+
+		if(m_thread.joinable())
+			m_thread.join();
+	}
+
 	void AudioStream::processStream()
 	{
 		bool regularStop = false;
@@ -154,6 +158,10 @@ namespace Saurobyte
 				// Read a 1s chunk of data
 				if(!m_file->readSecondIntoBuffer(buffer, m_loop))
 				{
+					// Let the engine know the stream ran out of data, once. The stream may be gone by the time
+					// the message is dispatched, so only its source is sent along
+					AudioDevice::postMessage("AudioStreamEnd", m_source);
+
 					regularStop = true; // TODO fix this, not good enough
 					//while(isPlaying())
 					//{
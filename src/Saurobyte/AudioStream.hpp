@@ -30,6 +30,7 @@
 
 #include <Saurobyte/AudioSource.hpp>
 #include <array>
+#include <atomic>
 #include <thread>
 
 namespace Saurobyte
@@ -54,8 +55,11 @@ namespace Saurobyte
 
 	private:
 
+		// The device stops streaming threads before it is destroyed
+		friend class AudioDevice;
+
 		bool m_loop;
-		bool m_requestStop;
+		std::atomic<bool> m_requestStop;
 		Time m_playingOffset;
 		std::thread m_thread;
 
@@ -64,6 +68,9 @@ namespace Saurobyte
 
 		void processStream();
 		void prepareStreaming();
+
+		// Stops and joins the streaming thread, if running
+		void stopStreaming();
 	};
 };
 
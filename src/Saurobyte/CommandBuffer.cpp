@@ -0,0 +1,220 @@
+/*
+
+	The MIT License (MIT)
+
+	Copyright (c) 2014 by Jakob Larsson
+
+	Permission is hereby granted, free of charge, to any person obtaining 
+	a copy of this software and associated documentation files (the "Software"), 
+	to deal in the Software without restriction, including without limitation the 
+	rights to use, copy, modify, merge, publish, distribute, sublicense, and/or 
+	sell copies of the Software, and to permit persons to whom the Software is 
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in 
+	all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+	IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+#include <Saurobyte/CommandBuffer.hpp>
+#include <Saurobyte/Entity.hpp>
+#include <Saurobyte/Archetype.hpp>
+#include <algorithm>
+
+namespace Saurobyte
+{
+	namespace
+	{
+		thread_local CommandBuffer *activeBuffer = nullptr;
+	};
+
+	CommandBuffer::Scope::Scope(CommandBuffer *buffer)
+		:
+		m_previous(activeBuffer)
+	{
+		activeBuffer = buffer;
+	}
+	CommandBuffer::Scope::~Scope()
+	{
+		activeBuffer = m_previous;
+	}
+
+	void CommandBuffer::addComponent(Entity &entity, BaseComponent *component)
+	{
+		m_commands.push_back({CommandTypes::AddComponent, &entity, component->getTypeID(), m_components.size()});
+		m_components.push_back(std::unique_ptr<BaseComponent>(component));
+	}
+	void CommandBuffer::removeComponent(Entity &entity, TypeID id)
+	{
+		m_commands.push_back({CommandTypes::RemoveComponent, &entity, id, 0});
+	}
+	void CommandBuffer::removeAllComponents(Entity &entity)
+	{
+		m_commands.push_back({CommandTypes::RemoveAllComponents, &entity, 0, 0});
+	}
+	void CommandBuffer::refreshEntity(Entity &entity)
+	{
+		m_commands.push_back({CommandTypes::Refresh, &entity, 0, 0});
+	}
+	void CommandBuffer::killEntity(Entity &entity)
+	{
+		m_commands.push_back({CommandTypes::Kill, &entity, 0, 0});
+	}
+	void CommandBuffer::detachEntity(Entity &entity)
+	{
+		m_commands.push_back({CommandTypes::Detach, &entity, 0, 0});
+	}
+	void CommandBuffer::updateProcessing(Entity &entity)
+	{
+		m_commands.push_back({CommandTypes::Processing, &entity, 0, 0});
+	}
+	void CommandBuffer::setParent(Entity &child, Entity *parent)
+	{
+		m_commands.push_back({CommandTypes::SetParent, &child, 0, 0, parent});
+	}
+
+	void CommandBuffer::flush()
+	{
+		// Make sure the commands are executed rather than recorded again
+		Scope scope(nullptr);
+
+		// Group the commands by entity, in the order the entities first appear
+		m_entityGroups.clear();
+		m_commandGroups.resize(m_commands.size());
+		m_commandOrder.resize(m_commands.size());
+		for(std::size_t i = 0; i < m_commands.size(); i++)
+		{
+			m_commandGroups[i] = m_entityGroups.insert(std::make_pair(m_commands[i].entity, m_entityGroups.size())).first->second;
+			m_commandOrder[i] = i;
+		}
+
+		std::stable_sort(m_commandOrder.begin(), m_commandOrder.end(), [this] (std::size_t lhs, std::size_t rhs)
+		{
+			return m_commandGroups[lhs] < m_commandGroups[rhs];
+		});
+
+		m_parentChanges.clear();
+		for(std::size_t begin = 0, end = 0; begin < m_commandOrder.size(); begin = end)
+		{
+			Entity *entity = m_commands[m_commandOrder[begin]].entity;
+			while(end < m_commandOrder.size() && m_commands[m_commandOrder[end]].entity == entity)
+				end++;
+
+			applyEntityCommands(begin, end);
+		}
+
+		// Parents may have gotten their TransformComponent from this buffer as well
+		for(std::size_t i = 0; i < m_parentChanges.size(); i++)
+			m_parentChanges[i].first->setParent(m_parentChanges[i].second);
+
+		m_commands.clear();
+		m_components.clear();
+	}
+	void CommandBuffer::applyEntityCommands(std::size_t begin, std::size_t end)
+	{
+		Entity &entity = *m_commands[m_commandOrder[begin]].entity;
+		bool removeAll = false, refresh = false, kill = false, detach = false, processing = false, setParent = false;
+		Entity *parent = nullptr;
+
+		m_addedComponents.clear();
+		m_removedComponents.clear();
+
+		// Replay the commands into their final outcome, where the last command on a component type wins
+		for(std::size_t i = begin; i < end; i++)
+		{
+			Command &command = m_commands[m_commandOrder[i]];
+			TypeID id = command.componentType;
+
+			auto addedItr = std::find_if(m_addedComponents.begin(), m_addedComponents.end(),
+				[id] (const std::unique_ptr<BaseComponent> &component) { return component->getTypeID() == id; });
+			auto removedItr = std::find(m_removedComponents.begin(), m_removedComponents.end(), id);
+
+			switch(command.type)
+			{
+			case CommandTypes::AddComponent:
+				if(addedItr != m_addedComponents.end())
+					*addedItr = std::move(m_components[command.component]);
+				else
+					m_addedComponents.push_back(std::move(m_components[command.component]));
+
+				if(removedItr != m_removedComponents.end())
+					m_removedComponents.erase(removedItr);
+				break;
+			case CommandTypes::RemoveComponent:
+				if(addedItr != m_addedComponents.end())
+					m_addedComponents.erase(addedItr);
+				if(removedItr == m_removedComponents.end())
+					m_removedComponents.push_back(id);
+				break;
+			case CommandTypes::RemoveAllComponents:
+				m_addedComponents.clear();
+				m_removedComponents.clear();
+				removeAll = true;
+				break;
+			case CommandTypes::Refresh:
+				refresh = true;
+				break;
+			case CommandTypes::Kill:
+				kill = true;
+				break;
+			case CommandTypes::Detach:
+				detach = true;
+				break;
+			case CommandTypes::Processing:
+				processing = true;
+				break;
+			case CommandTypes::SetParent:
+				setParent = true;
+				parent = command.parent;
+				break;
+			}
+		}
+
+		// Removing everything means removing the current components that were not added again
+		if(removeAll)
+		{
+			std::vector<BaseComponent*> components = entity.getComponents();
+			for(std::size_t i = 0; i < components.size(); i++)
+			{
+				TypeID id = components[i]->getTypeID();
+				bool readded = std::find_if(m_addedComponents.begin(), m_addedComponents.end(),
+					[id] (const std::unique_ptr<BaseComponent> &component) { return component->getTypeID() == id; }) != m_addedComponents.end();
+
+				if(!readded && std::find(m_removedComponents.begin(), m_removedComponents.end(), id) == m_removedComponents.end())
+					m_removedComponents.push_back(id);
+			}
+		}
+
+		// Component changes refresh the entity on their own when systems need to know
+		if(!m_addedComponents.empty() || !m_removedComponents.empty())
+			entity.changeComponents(m_addedComponents, m_removedComponents);
+		if(refresh)
+			entity.refresh();
+
+		if(processing)
+			entity.processingChanged();
+		if(detach)
+			entity.detach();
+		if(kill)
+			entity.kill();
+
+		if(setParent)
+			m_parentChanges.push_back(std::make_pair(&entity, parent));
+	}
+
+	bool CommandBuffer::isEmpty() const
+	{
+		return m_commands.empty();
+	}
+
+	CommandBuffer* CommandBuffer::getActive()
+	{
+		return activeBuffer;
+	}
+};
@@ -0,0 +1,154 @@
+/*
+
+	The MIT License (MIT)
+
+	Copyright (c) 2014 by Jakob Larsson
+
+	Permission is hereby granted, free of charge, to any person obtaining 
+	a copy of this software and associated documentation files (the "Software"), 
+	to deal in the Software without restriction, including without limitation the 
+	rights to use, copy, modify, merge, publish, distribute, sublicense, and/or 
+	sell copies of the Software, and to permit persons to whom the Software is 
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in 
+	all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+	IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+#ifndef SAUROBYTE_COMMAND_BUFFER_HPP
+#define SAUROBYTE_COMMAND_BUFFER_HPP
+
+#include <Saurobyte/IdentifierTypes.hpp>
+#include <Saurobyte/Component.hpp>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+
+namespace Saurobyte
+{
+	class Entity;
+
+	/*
+		CommandBuffer
+
+		Records structural changes to entities (adding and removing components,
+		killing entities, changing parents) so they can be applied later on a
+		single thread.
+		While a buffer is active on a thread, the corresponding Entity methods
+		called from that thread are recorded into it instead of being executed:
+
+			CommandBuffer commands;
+			{
+				CommandBuffer::Scope scope(&commands);
+				entity.kill(); // Recorded
+			}
+			commands.flush(); // Killed
+
+		Commands are coalesced per entity when flushed, so any amount of added
+		and removed components results in a single archetype move and a single
+		refresh of the entity.
+
+	*/
+	class CommandBuffer
+	{
+	public:
+
+		// Activates a buffer on the calling thread for the lifetime of the scope
+		class Scope
+		{
+		public:
+			explicit Scope(CommandBuffer *buffer);
+			~Scope();
+
+			Scope(const Scope &rhs) = delete;
+			Scope& operator= (const Scope &rhs) = delete;
+
+		private:
+			CommandBuffer *m_previous;
+		};
+
+		/**
+		 * Records the addition of a component, taking ownership of it
+		 * @param entity    The entity to add the component to
+		 * @param component Heap allocated component, moved into the entity once flushed
+		 */
+		void addComponent(Entity &entity, BaseComponent *component);
+		void removeComponent(Entity &entity, TypeID id);
+		void removeAllComponents(Entity &entity);
+
+		void refreshEntity(Entity &entity);
+		void killEntity(Entity &entity);
+		void detachEntity(Entity &entity);
+		void updateProcessing(Entity &entity);
+
+		/**
+		 * Records a change of parent, see TransformHierarchy::setParent. Parents are changed after the components
+		 * of all entities, so the TransformComponents they need may be added by the same buffer.
+		 * @param child  The entity to attach
+		 * @param parent The new parent of the entity, nullptr to detach it from its current parent
+		 */
+		void setParent(Entity &child, Entity *parent);
+
+		/**
+		 * Applies all recorded commands, then clears the buffer. The commands of an entity are applied
+		 * as a whole, with later commands overriding earlier ones on the same component type.
+		 */
+		void flush();
+
+		bool isEmpty() const;
+
+		/**
+		 * Returns the buffer active on the calling thread, nullptr if entity changes are executed immediately
+		 */
+		static CommandBuffer* getActive();
+
+	private:
+
+		enum CommandTypes
+		{
+			AddComponent,
+			RemoveComponent,
+			RemoveAllComponents,
+			Refresh,
+			Kill,
+			Detach,
+			Processing,
+			SetParent
+		};
+		struct Command
+		{
+			CommandTypes type;
+			Entity *entity;
+			TypeID componentType;
+
+			// Index into m_components for AddComponent commands
+			std::size_t component;
+
+			// New parent for SetParent commands
+			Entity *parent;
+		};
+
+		std::vector<Command> m_commands;
+		std::vector<std::unique_ptr<BaseComponent> > m_components;
+
+		// Scratch memory of flush, kept around to avoid reallocations
+		std::unordered_map<Entity*, std::size_t> m_entityGroups;
+		std::vector<std::size_t> m_commandGroups;
+		std::vector<std::size_t> m_commandOrder;
+		std::vector<std::unique_ptr<BaseComponent> > m_addedComponents;
+		std::vector<TypeID> m_removedComponents;
+		std::vector<std::pair<Entity*, Entity*> > m_parentChanges;
+
+		// Collapses the commands m_commandOrder[begin, end), all targeting the same entity
+		void applyEntityCommands(std::size_t begin, std::size_t end);
+	};
+};
+
+#endif
@@ -28,8 +28,36 @@ IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 namespace Saurobyte
 {
+	// Version 0 is older than any component, so systems that never ran see everything as changed
+	unsigned int BaseComponent::m_defaultVersion = 1;
+	thread_local unsigned int *BaseComponent::m_currentVersion = &BaseComponent::m_defaultVersion;
+
 	TypeID BaseComponent::getTypeID() const
 	{
 		return m_typeID;
 	}
+
+	void BaseComponent::markChanged()
+	{
+		m_version = *m_currentVersion;
+	}
+	unsigned int BaseComponent::getVersion() const
+	{
+		return m_version;
+	}
+
+	unsigned int BaseComponent::getCurrentVersion()
+	{
+		return *m_currentVersion;
+	}
+	void BaseComponent::advanceVersion()
+	{
+		(*m_currentVersion)++;
+	}
+	unsigned int* BaseComponent::setVersionCounter(unsigned int *counter)
+	{
+		unsigned int *previous = m_currentVersion;
+		m_currentVersion = counter == nullptr ? &m_defaultVersion : counter;
+		return previous;
+	}
 };
\ No newline at end of file
@@ -28,6 +28,8 @@ IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #define SAUROBYTE_COMPONENT_HPP
 
 #include <Saurobyte/IdentifierTypes.hpp>
+#include <Saurobyte/ComponentType.hpp>
+#include <Saurobyte/ComponentPool.hpp>
 #include <Saurobyte/LuaEnvironment.hpp>
 #include <string>
 #include <unordered_map>
@@ -51,12 +53,40 @@ namespace Saurobyte
 
 		const TypeID m_typeID;
 
+		// Change version of the last write to the component, see markChanged
+		unsigned int m_version;
+
+		// Change version stamped on writes made by the calling thread, advanced by the SystemPool
+		// between systems. Points to the version of the current World, see World::Scope.
+		static thread_local unsigned int *m_currentVersion;
+		static unsigned int m_defaultVersion;
+
 	protected:
 
 		BaseComponent(TypeID typeID) 
 			:
-			m_typeID(typeID)
+			m_typeID(typeID),
+			m_version(*m_currentVersion)
+		{};
+
+		// Copies (clones, templates) count as new components, while moving a component
+		// between archetypes keeps its version.
+		BaseComponent(const BaseComponent &other)
+			:
+			m_typeID(other.m_typeID),
+			m_version(*m_currentVersion)
 		{};
+		BaseComponent(BaseComponent &&other)
+			:
+			m_typeID(other.m_typeID),
+			m_version(other.m_version)
+		{};
+		// Assigning to a component is a write to it
+		BaseComponent& operator=(const BaseComponent&)
+		{
+			m_version = *m_currentVersion;
+			return *this;
+		};
 
 
 	public:
@@ -73,8 +103,27 @@ namespace Saurobyte
 
 		TypeID getTypeID() const;
 
+		/**
+		 * Marks the component as written to. Systems filtering on changes (see BaseSystem::setChangeFilter)
+		 * will process its entity the next time they run. Setters of components should call this.
+		 */
+		void markChanged();
+		// Returns the change version of the last write to the component
+		unsigned int getVersion() const;
+
+		static unsigned int getCurrentVersion();
+		// Starts a new change version, writes made after this are newer than all previous ones
+		static void advanceVersion();
+		/**
+		 * Makes the calling thread use another change version counter, keeping the versions of worlds
+		 * running on different threads apart. Use World::Scope rather than calling this directly.
+		 * @param  counter The counter to use, nullptr for the default counter used outside of any world
+		 * @return         The previously used counter
+		 */
+		static unsigned int* setVersionCounter(unsigned int *counter);
+
 		// Cloning function that must be overridden by deriving classes
-		virtual BaseComponent* clone()  = 0;
+		virtual BaseComponent* clone() const = 0;
 	};
 
 	template<typename TType> class Component : public BaseComponent
@@ -85,17 +134,39 @@ namespace Saurobyte
 		// Component names are optional, but they won't be accessable through Lua then
 		Component() 
 			:
-			BaseComponent(TypeIdGrabber::getUniqueTypeID<TType>())
+			BaseComponent(ComponentType::get<TType>().id) // Registers the storage info of the type
 		{};
+		Component(const Component &other) = default;
+		Component(Component &&other) = default;
+		Component& operator=(const Component &other) = default;
+		Component& operator=(Component &&other) = default;
 		virtual ~Component() {};
 
 		// Override cloning
-		virtual BaseComponent* clone() 
+		virtual BaseComponent* clone() const
 		{
 			// CRTP - Curiously Recurring Template Pattern
 			return new TType(static_cast<TType const&>(*this));
 		};
 
+		// Standalone components (clones, templates, components created with new) are
+		// allocated from the pool of their type rather than the global heap.
+		static void* operator new(std::size_t size)
+		{
+			return ComponentType::get<TType>().pool->allocate(size);
+		};
+		static void operator delete(void *component, std::size_t size)
+		{
+			ComponentType::get<TType>().pool->deallocate(component, size);
+		};
+
+		// Placement forms, used when constructing components in archetype storage
+		static void* operator new(std::size_t size, void *place)
+		{
+			return place;
+		};
+		static void operator delete(void *component, void *place) {};
+
 	};
 
 };
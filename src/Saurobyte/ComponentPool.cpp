@@ -0,0 +1,117 @@
+/*
+
+	The MIT License (MIT)
+
+	Copyright (c) 2014 by Jakob Larsson
+
+	Permission is hereby granted, free of charge, to any person obtaining 
+	a copy of this software and associated documentation files (the "Software"), 
+	to deal in the Software without restriction, including without limitation the 
+	rights to use, copy, modify, merge, publish, distribute, sublicense, and/or 
+	sell copies of the Software, and to permit persons to whom the Software is 
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in 
+	all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+	IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+#include <Saurobyte/ComponentPool.hpp>
+#include <algorithm>
+#include <new>
+
+namespace Saurobyte
+{
+	ComponentPool::ComponentPool(std::size_t objectSize, std::size_t alignment)
+		:
+		m_objectSize(objectSize),
+		m_freeList(nullptr),
+		m_stats()
+	{
+		// Slots must be able to hold a free list link and keep every object aligned
+		m_slotAlignment = std::max(alignment, alignof(FreeObject));
+		m_slotSize = std::max(objectSize, sizeof(FreeObject));
+		m_slotSize = (m_slotSize + m_slotAlignment - 1) / m_slotAlignment * m_slotAlignment;
+		m_slabCapacity = std::max<std::size_t>(1, SlabSize / m_slotSize);
+
+		m_stats.objectSize = m_slotSize;
+	}
+
+	void* ComponentPool::allocate(std::size_t size)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		if(size != m_objectSize)
+		{
+			++m_stats.fallbackCount;
+			return ::operator new(size);
+		}
+
+		if(m_freeList == nullptr)
+			grow();
+
+		FreeObject *object = m_freeList;
+		m_freeList = object->next;
+
+		++m_stats.allocationCount;
+		m_stats.peakCount = std::max(m_stats.peakCount, ++m_stats.liveCount);
+
+		return object;
+	}
+	void ComponentPool::deallocate(void *object, std::size_t size)
+	{
+		if(object == nullptr)
+			return;
+
+		if(size != m_objectSize)
+		{
+			::operator delete(object);
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		FreeObject *freeObject = static_cast<FreeObject*>(object);
+		freeObject->next = m_freeList;
+		m_freeList = freeObject;
+
+		--m_stats.liveCount;
+	}
+
+	void ComponentPool::reserve(std::size_t count)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		while(m_stats.capacity - m_stats.liveCount < count)
+			grow();
+	}
+
+	ComponentPool::Stats ComponentPool::getStats() const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_stats;
+	}
+
+	void ComponentPool::grow()
+	{
+		// Slots are a multiple of the alignment, so aligning the slab aligns every object
+		m_slabs.push_back(allocateAligned(m_slotSize * m_slabCapacity, m_slotAlignment));
+		unsigned char *slab = m_slabs.back().get();
+
+		// Link back to front so objects are handed out in address order
+		for(std::size_t i = m_slabCapacity; i > 0; i--)
+		{
+			FreeObject *object = reinterpret_cast<FreeObject*>(slab + (i - 1) * m_slotSize);
+			object->next = m_freeList;
+			m_freeList = object;
+		}
+
+		m_stats.capacity += m_slabCapacity;
+	}
+};
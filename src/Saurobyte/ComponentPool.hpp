@@ -0,0 +1,130 @@
+/*
+
+	The MIT License (MIT)
+
+	Copyright (c) 2014 by Jakob Larsson
+
+	Permission is hereby granted, free of charge, to any person obtaining 
+	a copy of this software and associated documentation files (the "Software"), 
+	to deal in the Software without restriction, including without limitation the 
+	rights to use, copy, modify, merge, publish, distribute, sublicense, and/or 
+	sell copies of the Software, and to permit persons to whom the Software is 
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in 
+	all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+	IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+#ifndef SAUROBYTE_COMPONENT_POOL_HPP
+#define SAUROBYTE_COMPONENT_POOL_HPP
+
+#include <Saurobyte/NonCopyable.hpp>
+#include <Saurobyte/AlignedMemory.hpp>
+#include <cstddef>
+#include <vector>
+#include <memory>
+#include <mutex>
+
+namespace Saurobyte
+{
+	/*
+		ComponentPool
+
+		Free-list allocator for heap allocated components of a single type,
+		carving objects out of fixed size slabs. Components attached to
+		entities live in archetype storage, the pool serves the standalone
+		ones: clones, entity templates and components created by deferred
+		structural changes. Component<TType> routes new/delete through the pool
+		of its type, so all of the above (including ComponentPtr) return
+		memory to the pool automatically.
+
+		Statistics of a type can be queried at runtime:
+
+			ComponentPool::Stats stats = ComponentType::get<TransformComponent>().pool->getStats();
+
+	*/
+	class ComponentPool : public NonCopyable
+	{
+	public:
+
+		struct Stats
+		{
+			// Size of a single object slot in bytes
+			std::size_t objectSize;
+
+			// Objects currently allocated, and the most ever allocated at once
+			std::size_t liveCount;
+			std::size_t peakCount;
+
+			// Total allocations made since the pool was created
+			std::size_t allocationCount;
+
+			// Object slots reserved in slabs
+			std::size_t capacity;
+
+			// Allocations that did not match the pooled size (i.e derived types) and went to the global heap
+			std::size_t fallbackCount;
+		};
+
+		// Size in bytes of a single slab of objects
+		static const std::size_t SlabSize = 16 * 1024;
+
+		/**
+		 * Creates an empty pool, slabs are only allocated once objects are
+		 * @param objectSize Size of the pooled type
+		 * @param alignment  Alignment of the pooled type
+		 */
+		ComponentPool(std::size_t objectSize, std::size_t alignment);
+
+		/**
+		 * Allocates memory for an object, thread safe
+		 * @param  size Size of the object, sizes other than the pooled size are passed on to the global heap
+		 * @return      Uninitialized memory for the object
+		 */
+		void* allocate(std::size_t size);
+		/**
+		 * Returns memory of an object to the pool, thread safe
+		 * @param object Memory retrieved from allocate
+		 * @param size   The size passed to allocate
+		 */
+		void deallocate(void *object, std::size_t size);
+
+		/**
+		 * Makes sure the specified amount of objects can be allocated without allocating new slabs
+		 * @param count The amount of objects
+		 */
+		void reserve(std::size_t count);
+
+		Stats getStats() const;
+
+	private:
+
+		struct FreeObject
+		{
+			FreeObject *next;
+		};
+
+		std::size_t m_objectSize;
+		std::size_t m_slotSize;
+		std::size_t m_slotAlignment;
+		std::size_t m_slabCapacity;
+
+		std::vector<AlignedBuffer> m_slabs;
+		FreeObject *m_freeList;
+
+		Stats m_stats;
+		mutable std::mutex m_mutex;
+
+		// Allocates a new slab and pushes its slots onto the free list
+		void grow();
+	};
+};
+
+#endif
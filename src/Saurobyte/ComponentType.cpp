@@ -0,0 +1,209 @@
+/*
+
+	The MIT License (MIT)
+
+	Copyright (c) 2014 by Jakob Larsson
+
+	Permission is hereby granted, free of charge, to any person obtaining
+	a copy of this software and associated documentation files (the "Software"),
+	to deal in the Software without restriction, including without limitation the
+	rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+	sell copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in
+	all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+	IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+#include <Saurobyte/ComponentType.hpp>
+#include <Saurobyte/ComponentPool.hpp>
+#include <Saurobyte/Component.hpp>
+#include <Saurobyte/Logger.hpp>
+#include <unordered_map>
+#include <memory>
+#include <atomic>
+#include <mutex>
+
+namespace Saurobyte
+{
+	namespace
+	{
+		// Registered component types and their allocators, keyed by TypeID
+		std::unordered_map<TypeID, std::unique_ptr<ComponentType> > m_componentTypes;
+		std::unordered_map<TypeID, std::unique_ptr<ComponentPool> > m_componentPools;
+
+		// Component names mapped to their TypeID, used by Lua
+		std::unordered_map<std::string, TypeID> m_componentNames;
+
+		// Worlds running on different threads register types concurrently, only registering locks
+		std::recursive_mutex m_registryMutex;
+
+		// Open addressing table of the type IDs that have a signature bit, looked up on every component access.
+		// Slots are only ever added, and are published by their used flag, so lookups don't lock.
+		struct TypeSlot
+		{
+			std::atomic<bool> isUsed;
+			TypeID id;
+			std::size_t signatureBit;
+			std::atomic<const ComponentType*> type;
+		};
+
+		constexpr std::size_t nextPowerOfTwo(std::size_t value, std::size_t power = 1)
+		{
+			return power >= value ? power : nextPowerOfTwo(value, power * 2);
+		}
+
+		// At most half full, so probing ends quickly
+		const std::size_t TypeTableSize = nextPowerOfTwo(SAUROBYTE_MAX_COMPONENT_TYPES * 2);
+		TypeSlot m_typeTable[TypeTableSize];
+		std::size_t m_signatureBitCount = 0;
+
+		// Returns the slot of the type ID, or the empty slot it would be placed in
+		TypeSlot& findSlot(TypeID id)
+		{
+			std::size_t index = id & (TypeTableSize - 1);
+			while(m_typeTable[index].isUsed.load(std::memory_order_acquire) && m_typeTable[index].id != id)
+				index = (index + 1) & (TypeTableSize - 1);
+
+			return m_typeTable[index];
+		}
+		// Adds the type ID to the table, the registry must be locked
+		TypeSlot& insertSlot(TypeID id)
+		{
+			TypeSlot &slot = findSlot(id);
+			if(slot.isUsed.load(std::memory_order_relaxed))
+				return slot;
+
+			if(m_signatureBitCount >= SAUROBYTE_MAX_COMPONENT_TYPES)
+				SAUROBYTE_FATAL_LOG("Too many component types, increase SAUROBYTE_MAX_COMPONENT_TYPES (currently ",
+					SAUROBYTE_MAX_COMPONENT_TYPES, ")");
+
+			slot.id = id;
+			slot.signatureBit = m_signatureBitCount++;
+			slot.type.store(nullptr, std::memory_order_relaxed);
+			slot.isUsed.store(true, std::memory_order_release);
+			return slot;
+		}
+	};
+
+	const ComponentType& ComponentType::registerType(const ComponentType &type)
+	{
+		std::lock_guard<std::recursive_mutex> lock(m_registryMutex);
+
+		auto itr = m_componentTypes.find(type.id);
+		if(itr != m_componentTypes.end())
+			SAUROBYTE_FATAL_LOG("Component types ", itr->second->typeName, " and ", type.typeName,
+				" share the type ID ", type.id, ", rename one of them");
+
+		std::unique_ptr<ComponentPool> &pool = m_componentPools[type.id];
+		pool = std::unique_ptr<ComponentPool>(new ComponentPool(type.size, type.alignment));
+
+		std::unique_ptr<ComponentType> &registeredType = m_componentTypes[type.id];
+		registeredType = std::unique_ptr<ComponentType>(new ComponentType(type));
+		registeredType->pool = pool.get();
+
+		// Publish the type to lookups by ID
+		insertSlot(type.id).type.store(registeredType.get(), std::memory_order_release);
+		return *registeredType;
+	}
+
+	const ComponentType* ComponentType::get(TypeID id)
+	{
+		TypeSlot &slot = findSlot(id);
+		return slot.isUsed.load(std::memory_order_acquire) ? slot.type.load(std::memory_order_acquire) : nullptr;
+	}
+	const ComponentType* ComponentType::get(const std::string &name)
+	{
+		std::lock_guard<std::recursive_mutex> lock(m_registryMutex);
+
+		auto itr = m_componentNames.find(name);
+		return itr == m_componentNames.end() ? nullptr : get(itr->second);
+	}
+
+	void ComponentType::setName(TypeID id, const std::string &name)
+	{
+		std::lock_guard<std::recursive_mutex> lock(m_registryMutex);
+
+		auto itr = m_componentTypes.find(id);
+		if(itr == m_componentTypes.end())
+			return;
+
+		// The name may be read without locking once set, so it is only ever set once
+		if(!itr->second->isNamed())
+		{
+			itr->second->name = name;
+			itr->second->m_named.value.store(true, std::memory_order_release);
+		}
+
+		m_componentNames[name] = id;
+	}
+	bool ComponentType::isNamed() const
+	{
+		return m_named.value.load(std::memory_order_acquire);
+	}
+
+	std::size_t ComponentType::getSignatureBit(TypeID id)
+	{
+		TypeSlot &slot = findSlot(id);
+		if(slot.isUsed.load(std::memory_order_acquire))
+			return slot.signatureBit;
+
+		std::lock_guard<std::recursive_mutex> lock(m_registryMutex);
+		return insertSlot(id).signatureBit;
+	}
+	ComponentSignature ComponentType::createSignature(const std::vector<TypeID> &ids)
+	{
+		ComponentSignature signature;
+		for(std::size_t i = 0; i < ids.size(); i++)
+			signature.set(getSignatureBit(ids[i]));
+
+		return signature;
+	}
+
+	const ComponentField* ComponentType::getField(const std::string &name) const
+	{
+		auto itr = m_fieldIndices.find(name);
+		return itr == m_fieldIndices.end() ? nullptr : &fields[itr->second];
+	}
+	void ComponentType::writeFields(const void *component, unsigned char *buffer) const
+	{
+		const unsigned char *data = static_cast<const unsigned char*>(component);
+		for(std::size_t i = 0; i < fields.size(); i++)
+		{
+			if(fields[i].isAlias)
+				continue;
+
+			std::memcpy(buffer, data + fields[i].offset, fields[i].size);
+			buffer += fields[i].size;
+		}
+	}
+	void ComponentType::readFields(void *component, const unsigned char *buffer) const
+	{
+		unsigned char *data = static_cast<unsigned char*>(component);
+		for(std::size_t i = 0; i < fields.size(); i++)
+		{
+			if(fields[i].isAlias)
+				continue;
+
+			std::memcpy(data + fields[i].offset, buffer, fields[i].size);
+			buffer += fields[i].size;
+		}
+
+		fieldsWritten(component);
+	}
+	void ComponentType::fieldsWritten(void *component) const
+	{
+		if(onFieldsWritten != nullptr)
+			onFieldsWritten(component);
+		else
+			toBase(component)->markChanged();
+	}
+};
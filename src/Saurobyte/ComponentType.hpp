@@ -0,0 +1,460 @@
+/*
+
+	The MIT License (MIT)
+
+	Copyright (c) 2014 by Jakob Larsson
+
+	Permission is hereby granted, free of charge, to any person obtaining
+	a copy of this software and associated documentation files (the "Software"),
+	to deal in the Software without restriction, including without limitation the
+	rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+	sell copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in
+	all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+	IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+#ifndef SAUROBYTE_COMPONENT_TYPE_HPP
+#define SAUROBYTE_COMPONENT_TYPE_HPP
+
+#include <Saurobyte/IdentifierTypes.hpp>
+#include <Saurobyte/Math/Vector3.hpp>
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <bitset>
+#include <new>
+#include <utility>
+#include <atomic>
+#include <unordered_map>
+#include <type_traits>
+
+// Maximum amount of component types that can be in use, keep it a multiple
+// of the machine word size so signature tests stay single instructions.
+#ifndef SAUROBYTE_MAX_COMPONENT_TYPES
+	#define SAUROBYTE_MAX_COMPONENT_TYPES 64
+#endif
+
+namespace Saurobyte
+{
+	class BaseComponent;
+	class ComponentPool;
+
+	// One bit per component type, see ComponentType::getSignatureBit
+	typedef std::bitset<SAUROBYTE_MAX_COMPONENT_TYPES> ComponentSignature;
+
+	template<typename TType> class ComponentReflection;
+
+	// Value types of fields that can be described through reflection
+	enum class FieldType
+	{
+		Bool,
+		Int,
+		UnsignedInt,
+		Float,
+		Double,
+		Vector3f
+	};
+
+	/*
+		ComponentField
+
+		Field of a component type described through reflection, located at a
+		fixed offset from the start of the component. See ComponentReflection.
+
+	*/
+	struct ComponentField
+	{
+		std::string name;
+		FieldType type;
+
+		// Offset in bytes from the start of the component, and the size of the value
+		std::size_t offset;
+		std::size_t size;
+
+		// Aliases view part of another field (i.e "x" of "position") and are not serialized
+		bool isAlias;
+	};
+
+	namespace detail
+	{
+		// Maps the C++ type of a field to its FieldType
+		template<typename TType> struct FieldTypeOf;
+		template<> struct FieldTypeOf<bool> { static const FieldType value = FieldType::Bool; };
+		template<> struct FieldTypeOf<int> { static const FieldType value = FieldType::Int; };
+		template<> struct FieldTypeOf<unsigned int> { static const FieldType value = FieldType::UnsignedInt; };
+		template<> struct FieldTypeOf<float> { static const FieldType value = FieldType::Float; };
+		template<> struct FieldTypeOf<double> { static const FieldType value = FieldType::Double; };
+		template<> struct FieldTypeOf<Vector3f> { static const FieldType value = FieldType::Vector3f; };
+
+		// Calls TType::reflect if the component type declares it
+		template<typename TType> auto reflectComponent(ComponentReflection<TType> &reflection, int)
+			-> decltype(TType::reflect(reflection), void())
+		{
+			TType::reflect(reflection);
+		};
+		template<typename TType> void reflectComponent(ComponentReflection<TType>&, long)
+		{
+
+		};
+
+		// Copies a component into a range, only instantiated for types reflected as bitwise copyable
+		template<typename TType> void copyConstructBitwise(void *destination, const BaseComponent &source, std::size_t count)
+		{
+			if(count == 0)
+				return;
+
+			// Construct one component properly, then double the copied range each step
+			new (destination) TType(static_cast<const TType&>(source));
+
+			unsigned char *bytes = static_cast<unsigned char*>(destination);
+			for(std::size_t copied = 1; copied < count; copied *= 2)
+				std::memcpy(bytes + copied * sizeof(TType), bytes, std::min(copied, count - copied) * sizeof(TType));
+		};
+	};
+
+	/*
+		ComponentType
+
+		Type-erased description of a component type. Allows component storage to
+		construct, move and destroy components in raw memory without knowing
+		their static type.
+
+		Types are registered once per process and shared by all worlds, the
+		registry may be used from several threads at once. Types may describe
+		their fields as well, see ComponentReflection.
+
+	*/
+	struct ComponentType
+	{
+		TypeID id;
+
+		// Name of the type as spelled by the compiler, see TypeIdGrabber::getTypeName
+		std::string typeName;
+
+		// Bit representing this type in component signatures
+		std::size_t signatureBit;
+
+		// Memory footprint of a single component of this type
+		std::size_t size;
+		std::size_t alignment;
+
+		// Allocator of standalone components of this type
+		ComponentPool *pool;
+
+		// Name as returned by BaseComponent::getName, empty until the first
+		// component of this type has been added to an entity (see isNamed).
+		std::string name;
+
+		// Move constructs the component at 'source' into 'destination'
+		void (*moveConstruct)(void *destination, void *source);
+		// Move constructs 'source' (which must be of this type) into 'destination'
+		void (*moveFrom)(void *destination, BaseComponent &source);
+		// Copy constructs 'source' (which must be of this type) into 'destination'
+		void (*copyConstruct)(void *destination, const BaseComponent &source);
+		// Copy constructs 'source' into 'count' consecutive components starting at 'destination'
+		void (*copyConstructRange)(void *destination, const BaseComponent &source, std::size_t count);
+		// Calls the destructor of the component at 'component'
+		void (*destroy)(void *component);
+		// Converts raw storage of this type to its BaseComponent
+		BaseComponent* (*toBase)(void *component);
+		// Converts a BaseComponent of this type back to its raw storage
+		void* (*fromBase)(BaseComponent *component);
+
+		// Fields described through reflection in the order they were added, empty if the type isn't reflected
+		std::vector<ComponentField> fields;
+		// Size in bytes of the serialized fields of a single component, see writeFields
+		std::size_t serializedSize;
+		// Whether or not components can be copied bitwise rather than by their copy constructor
+		bool isBitwiseCopyable;
+		// Called after fields have been written through reflection, nullptr if nothing needs to be updated
+		void (*onFieldsWritten)(void *component);
+		// Whether or not components are kept in a SparseSet rather than in archetypes, see ComponentReflection::sparseStorage
+		bool isSparse;
+
+		/**
+		 * Retrieves a field described through reflection by name
+		 * @param  name Name of the field
+		 * @return      The field, or nullptr if there's no such field
+		 */
+		const ComponentField* getField(const std::string &name) const;
+
+		/**
+		 * Writes the non-alias fields of a component to a buffer, in the order they were added
+		 * @param component Raw storage of a component of this type
+		 * @param buffer    Buffer with room for serializedSize bytes
+		 */
+		void writeFields(const void *component, unsigned char *buffer) const;
+		/**
+		 * Reads the non-alias fields of a component from a buffer filled by writeFields. The component is
+		 * marked as changed, see BaseComponent::markChanged.
+		 * @param component Raw storage of a component of this type
+		 * @param buffer    Buffer holding serializedSize bytes
+		 */
+		void readFields(void *component, const unsigned char *buffer) const;
+		/**
+		 * Notifies a component that its fields have been written through reflection, marking it as changed
+		 * @param component Raw storage of a component of this type
+		 */
+		void fieldsWritten(void *component) const;
+
+		/**
+		 * Retrieves the type description of the specified component type, registering it on first use
+		 * @return The type description
+		 */
+		template<typename TType> static const ComponentType& get()
+		{
+			// Registered types are cached per type, so every lookup but the first is a single load
+			const ComponentType *type = CachedType<TType>::type.load(std::memory_order_acquire);
+			return type != nullptr ? *type : registerSlot<TType>();
+		};
+
+		/**
+		 * Retrieves the type description of an already registered component type
+		 * @param  id The type identifier of the component
+		 * @return    The type description, or nullptr if no such type has been registered
+		 */
+		static const ComponentType* get(TypeID id);
+
+		/**
+		 * Retrieves the type description of an already registered component type by its name
+		 * @param  name The name of the component, as returned by BaseComponent::getName
+		 * @return      The type description, or nullptr if no such type has been named yet
+		 */
+		static const ComponentType* get(const std::string &name);
+
+		/**
+		 * Associates a name with a registered component type, allowing it to be retrieved by name (i.e from Lua)
+		 * @param id   The type identifier of the component
+		 * @param name The name of the component
+		 */
+		static void setName(TypeID id, const std::string &name);
+		/**
+		 * Returns whether or not the type has been given a name, safe to call while another thread sets it
+		 */
+		bool isNamed() const;
+
+		/**
+		 * Retrieves the signature bit of a component type. Bits are handed out densely in order of first use,
+		 * so the type does not need to be registered yet.
+		 * @param  id The type identifier of the component
+		 * @return    Index of the bit representing the component type
+		 */
+		static std::size_t getSignatureBit(TypeID id);
+
+		/**
+		 * Compiles a list of component types into a signature
+		 * @param  ids The type identifiers of the components
+		 * @return     Signature with the bits of all the component types set
+		 */
+		static ComponentSignature createSignature(const std::vector<TypeID> &ids);
+
+	private:
+
+		// Copyable atomic flag, set once name may be read without locking the registry
+		struct NamedFlag
+		{
+			std::atomic<bool> value;
+
+			NamedFlag() : value(false) {};
+			NamedFlag(const NamedFlag &other) : value(other.value.load()) {};
+		};
+		NamedFlag m_named;
+
+		// Field names mapped to their index in fields
+		std::unordered_map<std::string, std::size_t> m_fieldIndices;
+		template<typename TType> friend class ComponentReflection;
+
+		static const ComponentType& registerType(const ComponentType &type);
+
+		// Slot holding the registered description of a component type, nullptr until first used
+		template<typename TType> struct CachedType
+		{
+			static std::atomic<const ComponentType*> type;
+		};
+		template<typename TType> static const ComponentType& registerSlot()
+		{
+			// Static in a template function, so registration only happens once per type
+			static const ComponentType &type = registerType(create<TType>());
+			CachedType<TType>::type.store(&type, std::memory_order_release);
+			return type;
+		};
+
+		template<typename TType> static ComponentType create()
+		{
+			ComponentType type;
+			type.id = TypeIdGrabber::getUniqueTypeID<TType>();
+			type.typeName = TypeIdGrabber::getTypeName<TType>();
+			type.signatureBit = getSignatureBit(type.id);
+			type.size = sizeof(TType);
+			type.alignment = alignof(TType);
+			type.moveConstruct = [] (void *destination, void *source)
+			{
+				new (destination) TType(std::move(*static_cast<TType*>(source)));
+			};
+			type.moveFrom = [] (void *destination, BaseComponent &source)
+			{
+				new (destination) TType(std::move(static_cast<TType&>(source)));
+			};
+			type.copyConstruct = [] (void *destination, const BaseComponent &source)
+			{
+				new (destination) TType(static_cast<const TType&>(source));
+			};
+			type.copyConstructRange = [] (void *destination, const BaseComponent &source, std::size_t count)
+			{
+				const TType &component = static_cast<const TType&>(source);
+				TType *components = static_cast<TType*>(destination);
+				for(std::size_t i = 0; i < count; i++)
+					new (components + i) TType(component);
+			};
+			type.destroy = [] (void *component)
+			{
+				static_cast<TType*>(component)->~TType();
+			};
+			type.toBase = [] (void *component) -> BaseComponent*
+			{
+				return static_cast<TType*>(component);
+			};
+			type.fromBase = [] (BaseComponent *component) -> void*
+			{
+				return static_cast<TType*>(component);
+			};
+
+			type.serializedSize = 0;
+			type.isBitwiseCopyable = false;
+			type.onFieldsWritten = nullptr;
+			type.isSparse = false;
+
+			ComponentReflection<TType> reflection(type);
+			detail::reflectComponent<TType>(reflection, 0);
+
+			return type;
+		};
+	};
+	template<typename TType> std::atomic<const ComponentType*> ComponentType::CachedType<TType>::type(nullptr);
+
+	/*
+		ComponentReflection
+
+		Describes the layout of a component type, allowing generic code to copy,
+		serialize and expose components to Lua without per-type code. Component
+		types opt in by declaring a static reflect function, which is called when
+		the type is registered:
+
+			static void reflect(ComponentReflection<HealthComponent> &reflection)
+			{
+				reflection
+					.field("health", &HealthComponent::m_health)
+					.field("regeneration", &HealthComponent::m_regeneration)
+					.bitwiseCopyable();
+			};
+
+	*/
+	template<typename TType> class ComponentReflection
+	{
+	public:
+
+		explicit ComponentReflection(ComponentType &type)
+			:
+			m_type(type)
+		{};
+
+		/**
+		 * Describes a field of the component
+		 * @param name   Name of the field, i.e used by Lua
+		 * @param member Pointer to the member, which must be of a type in FieldType
+		 */
+		template<typename TField> ComponentReflection& field(const std::string &name, TField TType::*member)
+		{
+			addField(name, detail::FieldTypeOf<TField>::value, offsetOf(member), sizeof(TField), false);
+			return *this;
+		};
+		/**
+		 * Describes a part of another field under its own name, i.e the x coordinate of a position
+		 * @param name   Name of the field
+		 * @param member Pointer to the member containing the field
+		 * @param part   Pointer to the field within the member, which must be of a type in FieldType
+		 */
+		template<typename TMember, typename TField> ComponentReflection& field(
+			const std::string &name,
+			TMember TType::*member,
+			TField TMember::*part)
+		{
+			addField(name, detail::FieldTypeOf<TField>::value, offsetOf(member) + offsetOf(part), sizeof(TField), true);
+			return *this;
+		};
+
+		/**
+		 * Allows components to be copied bitwise, only valid if copying the component doesn't need to do anything
+		 * besides copying its memory (no owned resources or pointers into itself)
+		 */
+		ComponentReflection& bitwiseCopyable()
+		{
+			m_type.isBitwiseCopyable = true;
+			m_type.copyConstructRange = &detail::copyConstructBitwise<TType>;
+			return *this;
+		};
+
+		/**
+		 * Stores components of this type in a SparseSet of their own rather than in archetypes. Adding and removing them
+		 * doesn't move the other components of the entity, which suits tags and components that come and go often.
+		 * Sparse components are not part of archetypes, so EntityView doesn't see them, iterate EntityPool::getSparseSet instead.
+		 */
+		ComponentReflection& sparseStorage()
+		{
+			m_type.isSparse = true;
+			return *this;
+		};
+
+		/**
+		 * Sets a member function to call after fields have been written through reflection, which should mark the
+		 * component as changed (see BaseComponent::markChanged)
+		 */
+		template<void (TType::*TFunction)()> ComponentReflection& onWrite()
+		{
+			m_type.onFieldsWritten = [] (void *component)
+			{
+				(static_cast<TType*>(component)->*TFunction)();
+			};
+			return *this;
+		};
+
+	private:
+
+		ComponentType &m_type;
+
+		void addField(const std::string &name, FieldType type, std::size_t offset, std::size_t size, bool isAlias)
+		{
+			ComponentField field = { name, type, offset, size, isAlias };
+			m_type.m_fieldIndices[name] = m_type.fields.size();
+			m_type.fields.push_back(field);
+
+			if(!isAlias)
+				m_type.serializedSize += size;
+		};
+
+		template<typename TClass, typename TField> static std::size_t offsetOf(TField TClass::*member)
+		{
+			// Only addresses are computed, the storage never holds an object
+			static typename std::aligned_storage<sizeof(TClass), alignof(TClass)>::type storage;
+			const TClass *object = reinterpret_cast<const TClass*>(&storage);
+
+			return
+				reinterpret_cast<const unsigned char*>(&(object->*member)) -
+				reinterpret_cast<const unsigned char*>(object);
+		};
+	};
+};
+
+#endif
@@ -31,6 +31,7 @@ IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <unordered_set>
 
 #include <Saurobyte/Component.hpp>
+#include <Saurobyte/Message.hpp>
 #include <Saurobyte/Logger.hpp>
 
 namespace Saurobyte
@@ -51,7 +52,7 @@ namespace Saurobyte
 		int sandBox;
 
 		// Events that the script is subscribed to
-		std::unordered_set<std::string> subscribedEvents;
+		std::unordered_set<MessageID> subscribedEvents;
 
 		LuaComponent(const std::string fileName);
 
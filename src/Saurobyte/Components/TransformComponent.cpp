@@ -9,19 +9,47 @@ namespace Saurobyte
 		:
 		m_position(x, y, z),
 		m_rotation(0,0,0),
-		m_modelTransform(1)
+		m_hasParent(false),
+		m_isTransformDirty(true)
 	{
-
+		updateLocalTransform();
 	}
 	TransformComponent::TransformComponent(const Vector3f &position, const Vector3f &rotation)
 		:
 		m_position(position),
 		m_rotation(rotation),
-		m_modelTransform(1)
+		m_hasParent(false),
+		m_isTransformDirty(true)
+	{
+		updateLocalTransform();
+	}
+	TransformComponent::TransformComponent(const TransformComponent &other)
+		:
+		Component<TransformComponent>(other),
+		m_position(other.m_position),
+		m_rotation(other.m_rotation),
+		m_localTransform(other.m_localTransform),
+		m_modelTransform(other.m_localTransform),
+		m_hasParent(false),
+		m_isTransformDirty(true)
 	{
 
 	}
 
+	TransformComponent& TransformComponent::operator=(const TransformComponent &other)
+	{
+		Component<TransformComponent>::operator=(other);
+		m_position = other.m_position;
+		m_rotation = other.m_rotation;
+		updateTransform();
+
+		return *this;
+	}
+	TransformComponent& TransformComponent::operator=(TransformComponent &&other)
+	{
+		return *this = static_cast<const TransformComponent&>(other);
+	}
+
 	void TransformComponent::setPosition(float x, float y, float z)
 	{
 		m_position = Vector3f(x, y, z);
@@ -67,55 +95,15 @@ namespace Saurobyte
 	}
 
 
-	void TransformComponent::onLuaSet(const std::string& valueName, LuaEnvironment &env)
-	{
-		if(valueName == "position")
-		{
-			m_position.x = env.readArg<float>();
-			m_position.y = env.readArg<float>();
-			m_position.z = env.readArg<float>();
-		}
-		else if(valueName == "x")
-			m_position.x = env.readArg<float>();
-		else if(valueName == "y")
-			m_position.y = env.readArg<float>();
-		else if(valueName == "z")
-			m_position.z = env.readArg<float>();
-		else if(valueName == "rotation")
-		{
-			m_rotation.x = env.readArg<float>();
-			m_rotation.y = env.readArg<float>();
-			m_rotation.z = env.readArg<float>();
-		}
-
-	}
-	int TransformComponent::onLuaGet(const std::string& valueName, LuaEnvironment &env)
-	{
-		if(valueName == "position")
-		{
-			env.pushArgs(m_position.x, m_position.y, m_position.z);
-			return 3;
-		}
-		else if(valueName == "x")
-		{
-			env.pushArgs(m_position.x);
-			return 1;
-		}
-		else if(valueName == "y")
-		{
-			env.pushArgs(m_position.y);
-			return 1;
-		}
-		else if(valueName == "z")
-		{
-			env.pushArgs(m_position.z);
-			return 1;
-		}
-		else if(valueName == "rotation")
-		{
-			env.pushArgs(m_rotation.x, m_rotation.y, m_rotation.z);
-			return 3;
-		}
+	void TransformComponent::reflect(ComponentReflection<TransformComponent> &reflection)
+	{
+		reflection
+			.field("position", &TransformComponent::m_position)
+			.field("rotation", &TransformComponent::m_rotation)
+			.field("x", &TransformComponent::m_position, &Vector3f::x)
+			.field("y", &TransformComponent::m_position, &Vector3f::y)
+			.field("z", &TransformComponent::m_position, &Vector3f::z)
+			.onWrite<&TransformComponent::updateTransform>();
 	}
 
 	std::string TransformComponent::getName() const
@@ -132,6 +120,10 @@ namespace Saurobyte
 	{
 		return m_rotation;
 	}
+	const Matrix4& TransformComponent::getLocalTransform() const
+	{
+		return m_localTransform;
+	}
 	const Matrix4& TransformComponent::getTransform() const
 	{
 		return m_modelTransform;
@@ -141,16 +133,25 @@ namespace Saurobyte
 
 	void TransformComponent::updateTransform()
 	{
-		/* TODO Matrix4 positionMat = glm::translate(glm::mat4(1), m_position);
-
+		// Every setter ends up here
+		markChanged();
+		updateLocalTransform();
+	}
+	void TransformComponent::updateLocalTransform()
+	{
 		Matrix4 rotationMat = Matrix4(1);
 		rotationMat = glm::rotate(rotationMat, m_rotation.x, glm::vec3(0, 1, 0));
 		rotationMat = glm::rotate(rotationMat, m_rotation.y, glm::vec3(-1, 0, 0));
 		rotationMat = glm::rotate(rotationMat, m_rotation.z, glm::vec3(0, 0, -1));
 
-		// Set model transform by multiplying rotaton and position
-		m_modelTransform = rotationMat * positionMat;*/
+		// Rotate around the origin of the entity before moving it, so children
+		// keep their offset from the parent as it rotates.
+		m_localTransform = glm::translate(Matrix4(1), glm::vec3(m_position.x, m_position.y, m_position.z)) * rotationMat;
+		m_isTransformDirty = true;
 
+		// Entities with a parent are placed by the hierarchy
+		if(!m_hasParent)
+			m_modelTransform = m_localTransform;
 	}
 
 };
\ No newline at end of file
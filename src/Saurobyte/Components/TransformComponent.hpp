@@ -15,16 +15,33 @@ namespace Saurobyte
 		Vector3f m_position;
 		Vector3f m_rotation;
 
-		// Final model transform, complete with rotation and translation
+		// Transform relative to the parent, complete with rotation and translation
+		Matrix4 m_localTransform;
+		// Final model transform, the local transform combined with those of the parents
 		Matrix4 m_modelTransform;
 
+		// Set while the entity has a parent in the TransformHierarchy, which then computes the
+		// model transform. Dirty transforms have changed since the hierarchy last saw them.
+		bool m_hasParent;
+		bool m_isTransformDirty;
+		friend class TransformHierarchy;
+
 		void updateTransform();
+		void updateLocalTransform();
 
 	public:
 
 		explicit TransformComponent(float x = 0, float y = 0, float z = 0);
 		explicit TransformComponent(const Vector3f &position, const Vector3f &rotation = Vector3f(0,0,0));
 
+		// Copies start out without a parent, the entity they end up in isn't part of the hierarchy
+		TransformComponent(const TransformComponent &other);
+		TransformComponent(TransformComponent &&other) = default;
+
+		// Assigning copies the position and rotation, the component keeps its own parent
+		TransformComponent& operator=(const TransformComponent &other);
+		TransformComponent& operator=(TransformComponent &&other);
+
 		// Sets the position
 		void setPosition(float x, float y, float z);
 		void setPosition(const Vector3f &position);
@@ -42,14 +59,17 @@ namespace Saurobyte
 		void rotate(float x, float y = 0, float z = 0);
 		void rotate(const Vector3f &rotation);
 
-		virtual void onLuaSet(const std::string& valueName, LuaEnvironment &env);
-		virtual int onLuaGet(const std::string& valueName, LuaEnvironment &env);
+		// Exposes position and rotation (and the x, y and z of the position) to Lua and serialization
+		static void reflect(ComponentReflection<TransformComponent> &reflection);
 
 		virtual std::string getName() const;
 
 		const Vector3f& getPosition() const;
 		const Vector3f& getRotation() const;
-		const Matrix4& getTransform() const; 
+		// Returns the transform relative to the parent
+		const Matrix4& getLocalTransform() const;
+		// Returns the world transform, which is kept up to date by the TransformHierarchy for entities with a parent
+		const Matrix4& getTransform() const;
 
 	};
 };
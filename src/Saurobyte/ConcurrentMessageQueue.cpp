@@ -0,0 +1,82 @@
+/*
+
+	The MIT License (MIT)
+
+	Copyright (c) 2014 by Jakob Larsson
+
+	Permission is hereby granted, free of charge, to any person obtaining 
+	a copy of this software and associated documentation files (the "Software"), 
+	to deal in the Software without restriction, including without limitation the 
+	rights to use, copy, modify, merge, publish, distribute, sublicense, and/or 
+	sell copies of the Software, and to permit persons to whom the Software is 
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in 
+	all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+	IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+#include <Saurobyte/ConcurrentMessageQueue.hpp>
+
+namespace Saurobyte
+{
+	const std::size_t ConcurrentMessageQueue::SlotSize;
+
+	ConcurrentMessageQueue::ConcurrentMessageQueue(std::size_t capacity)
+		:
+		m_mask(0),
+		m_pushPosition(0),
+		m_popPosition(0)
+	{
+		// Positions are mapped to slots by masking, so the capacity is a power of two
+		std::size_t slotCount = 2;
+		while(slotCount < capacity)
+			slotCount *= 2;
+
+		m_slots.reset(new Slot[slotCount]);
+		m_mask = slotCount - 1;
+
+		for(std::size_t i = 0; i < slotCount; i++)
+		{
+			m_slots[i].sequence.store(i, std::memory_order_relaxed);
+			m_slots[i].message = nullptr;
+			m_slots[i].destroy = nullptr;
+		}
+	}
+	ConcurrentMessageQueue::~ConcurrentMessageQueue()
+	{
+		while(front() != nullptr)
+			pop();
+	}
+
+	Message* ConcurrentMessageQueue::front()
+	{
+		Slot &slot = m_slots[m_popPosition & m_mask];
+		if(slot.sequence.load(std::memory_order_acquire) != m_popPosition + 1)
+			return nullptr;
+
+		return slot.message;
+	}
+	void ConcurrentMessageQueue::pop()
+	{
+		Slot &slot = m_slots[m_popPosition & m_mask];
+		if(slot.destroy != nullptr)
+			slot.destroy(slot.message);
+
+		// Hand the slot to the producer of the next lap
+		slot.sequence.store(m_popPosition + m_mask + 1, std::memory_order_release);
+		m_popPosition++;
+	}
+
+	std::size_t ConcurrentMessageQueue::getCapacity() const
+	{
+		return m_mask + 1;
+	}
+};
@@ -0,0 +1,138 @@
+/*
+
+	The MIT License (MIT)
+
+	Copyright (c) 2014 by Jakob Larsson
+
+	Permission is hereby granted, free of charge, to any person obtaining 
+	a copy of this software and associated documentation files (the "Software"), 
+	to deal in the Software without restriction, including without limitation the 
+	rights to use, copy, modify, merge, publish, distribute, sublicense, and/or 
+	sell copies of the Software, and to permit persons to whom the Software is 
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in 
+	all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+	IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+#ifndef SAUROBYTE_CONCURRENT_MESSAGE_QUEUE_HPP
+#define SAUROBYTE_CONCURRENT_MESSAGE_QUEUE_HPP
+
+#include <Saurobyte/Message.hpp>
+#include <Saurobyte/NonCopyable.hpp>
+#include <type_traits>
+#include <utility>
+#include <atomic>
+#include <memory>
+#include <new>
+
+namespace Saurobyte
+{
+	/*
+		ConcurrentMessageQueue
+
+		Bounded queue of messages posted from any thread and consumed by a
+		single thread, see MessageCentral::postMessage. Producers claim a slot
+		with a compare-and-swap and construct the message in place, so posting
+		never locks nor allocates. Every slot has room for SlotSize bytes,
+		larger data must be posted through a pointer or handle.
+
+	*/
+	class ConcurrentMessageQueue : public NonCopyable
+	{
+	public:
+
+		// Size in bytes of the storage of a single message, including the Message base
+		static const std::size_t SlotSize = 128;
+
+		/**
+		 * @param capacity Maximum amount of messages in the queue, rounded up to a power of two
+		 */
+		explicit ConcurrentMessageQueue(std::size_t capacity);
+		~ConcurrentMessageQueue();
+
+		/**
+		 * Constructs a message in the queue, may be called from any thread
+		 * @param  args Arguments passed to the constructor of the message
+		 * @return      False if the queue is full, in which case the message is dropped
+		 */
+		template<typename TMessage, typename... TArgs> bool push(TArgs&&... args)
+		{
+			static_assert(sizeof(TMessage) <= SlotSize, "Message data too large to be posted, post a pointer to it instead");
+
+			std::size_t position = m_pushPosition.load(std::memory_order_relaxed);
+			Slot *slot = nullptr;
+			while(true)
+			{
+				slot = &m_slots[position & m_mask];
+				std::size_t sequence = slot->sequence.load(std::memory_order_acquire);
+
+				// The slot is free for this position, try to claim it
+				if(sequence == position)
+				{
+					if(m_pushPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+						break;
+				}
+				// The slot still holds a message from a lap ago, the queue is full
+				else if(sequence < position)
+					return false;
+				else
+					position = m_pushPosition.load(std::memory_order_relaxed);
+			}
+
+			slot->message = new (&slot->storage) TMessage(std::forward<TArgs>(args)...);
+			slot->destroy = std::is_trivially_destructible<TMessage>::value ? nullptr : &destroy<TMessage>;
+
+			// Publish the message to the consumer
+			slot->sequence.store(position + 1, std::memory_order_release);
+			return true;
+		};
+
+		/**
+		 * Returns the oldest message of the queue, only to be called from the consuming thread
+		 * @return The message, or a null pointer if the queue is empty
+		 */
+		Message* front();
+		/**
+		 * Destroys the oldest message and frees its slot, only to be called from the consuming thread
+		 * after front returned a message
+		 */
+		void pop();
+
+		std::size_t getCapacity() const;
+
+	private:
+
+		struct Slot
+		{
+			// Equals the position a producer may claim the slot at, or that position + 1 once the message is published
+			std::atomic<std::size_t> sequence;
+
+			Message *message;
+			void (*destroy)(Message *message);
+			typename std::aligned_storage<SlotSize>::type storage;
+		};
+		std::unique_ptr<Slot[]> m_slots;
+		std::size_t m_mask;
+
+		// Padded so producers and the consumer work on different cache lines
+		std::atomic<std::size_t> m_pushPosition;
+		char m_padding[64];
+		std::size_t m_popPosition;
+
+		template<typename TMessage> static void destroy(Message *message)
+		{
+			static_cast<TMessage*>(message)->~TMessage();
+		};
+	};
+};
+
+#endif
@@ -12,6 +12,7 @@
 #include <Saurobyte/InputImpl.hpp>
 #include <Saurobyte/AudioDevice.hpp>
 #include <Saurobyte/VideoDevice.hpp>
+#include <thread>
 
 namespace Saurobyte
 {
@@ -19,15 +20,13 @@ namespace Saurobyte
 
 	Engine::Engine(const std::string &title, unsigned int width, unsigned int height, Window::WindowModes windowMode)
 		:
-		m_entityPool(this),
-		m_systemPool(this),
-		m_scenePool(this),
+		// The main thread helps out, so leave a hardware thread for it
+		m_world(std::thread::hardware_concurrency() > 1 ? std::thread::hardware_concurrency() - 1 : 0),
 		m_frameCounter(),
 		m_audioDevice(nullptr),
 		m_videoDevice(nullptr),
 		m_luaEnvironment(),
-		m_luaConfig(m_luaEnvironment),
-		m_messageCentral()
+		m_luaConfig(m_luaEnvironment)
 	{
 		if(m_engineInstanceExists)
 			SAUROBYTE_FATAL_LOG("Only one Engine instance may exist!");
@@ -49,13 +48,13 @@ namespace Saurobyte
 		m_frameCounter.limitFps(300);
 
 		m_videoDevice = std::unique_ptr<VideoDevice>(new VideoDevice(*this, title, width, height, windowMode));
-		m_audioDevice = std::unique_ptr<AudioDevice>(new AudioDevice());
+		m_audioDevice = std::unique_ptr<AudioDevice>(new AudioDevice(m_world.getMessageCentral()));
 
 		// TODO init devices here when log is loaded
 
 
 		// Add the built in systems
-		m_systemPool.addSystem(new LuaSystem(this));
+		m_world.getSystemPool().addSystem(new LuaSystem(this));
 		
 		// Expose Lua API
 		LuaEnv_Engine::exposeToLua(this);
@@ -133,7 +132,7 @@ namespace Saurobyte
 					if(event.key.windowID == getWindow().getID())
 					{
 						sendMessage<KeyEvent>(
-							event.type == SDL_KEYDOWN ? "KeyDown" : "KeyUp",
+							event.type == SDL_KEYDOWN ? MessageID("KeyDown") : MessageID("KeyUp"),
 							KeyEvent(
 								internal::InputImpl::toSaurobyteKey(event.key.keysym.scancode),
 								event.key.state == SDL_PRESSED,
@@ -150,7 +149,7 @@ namespace Saurobyte
 							button = event.button.button == SDL_BUTTON_RIGHT ? MouseButton::Right : MouseButton::Middle;
 
 						sendMessage<MouseButtonEvent>(
-							event.type == SDL_MOUSEBUTTONDOWN ? "MouseButtonDown" : "MouseButtonUp",
+							event.type == SDL_MOUSEBUTTONDOWN ? MessageID("MouseButtonDown") : MessageID("MouseButtonUp"),
 							MouseButtonEvent(
 								event.button.x,
 								event.button.y,
@@ -180,15 +179,10 @@ namespace Saurobyte
 		while(handleEvents())
 		{
 			m_frameCounter.update();
-
-			// Process frame start entity cleanup
-			m_scenePool.frameCleanup();
-			m_entityPool.frameCleanup();
-
 			m_videoDevice->clearBuffers();
 
-			// Process the systems and their entities
-			m_systemPool.processSystems();
+			// Process frame start cleanup, then the systems and their entities
+			m_world.frame(m_frameCounter.getDelta());
 			
 			//glFlush();
 
@@ -209,33 +203,49 @@ namespace Saurobyte
 
 	Entity& Engine::createEntity()
 	{
-		return m_entityPool.createEntity();
+		return m_world.createEntity();
 	}
 	Entity& Engine::createEntity(const std::string &templateName)
 	{
-		return m_entityPool.createEntity(templateName);
+		return m_world.createEntity(templateName);
 	}
 	Scene& Engine::createScene(const std::string &name)
 	{
-		return m_scenePool.createScene(name);
+		return m_world.createScene(name);
 	}
 
 	Scene* Engine::getActiveScene()
 	{
-		return m_scenePool.getActiveScene();
+		return m_world.getActiveScene();
 	}
 	void Engine::changeScene(const std::string &sceneName)
 	{
-		m_scenePool.changeScene(sceneName);
+		m_world.changeScene(sceneName);
 	}
 
 	void Engine::sendMessage(const Message &message)
 	{
-		m_messageCentral.sendMessage(message);
+		m_world.sendMessage(message);
+	}
+	void Engine::sendMessage(const MessageID &messageID, Entity *entity)
+	{
+		m_world.sendMessage(messageID, entity);
+	}
+	void Engine::queueMessage(const MessageID &messageID, Entity *entity)
+	{
+		m_world.queueMessage(messageID, entity);
 	}
-	void Engine::sendMessage(const std::string &messageName, Entity *entity)
+	bool Engine::postMessage(const MessageID &messageID, Entity *entity)
 	{
-		m_messageCentral.sendMessage(Message(messageName, entity));
+		return m_world.postMessage(messageID, entity);
+	}
+	void Engine::sendMessageInRegion(const MessageID &messageID, const BoundingBox &region)
+	{
+		m_world.sendMessageInRegion(messageID, region);
+	}
+	void Engine::sendMessageInRadius(const MessageID &messageID, const Vector3f &center, float radius)
+	{
+		m_world.sendMessageInRadius(messageID, center, radius);
 	}
 
 	bool Engine::runScript(const std::string &filePath)
@@ -252,21 +262,25 @@ namespace Saurobyte
 		return m_frameCounter.getDelta();
 	}
 
+	World& Engine::getWorld()
+	{
+		return m_world;
+	}
 	EntityPool& Engine::getEntityPool()
 	{
-		return m_entityPool;
+		return m_world.getEntityPool();
 	}
 	SystemPool& Engine::getSystemPool()
 	{
-		return m_systemPool;
+		return m_world.getSystemPool();
 	}
 	ScenePool& Engine::getScenePool()
 	{
-		return m_scenePool;
+		return m_world.getScenePool();
 	}
 	MessageCentral& Engine::getMessageCentral()
 	{
-		return m_messageCentral;
+		return m_world.getMessageCentral();
 	}
 	Window& Engine::getWindow()
 	{
@@ -27,10 +27,7 @@
 #ifndef SAUROBYTE_GAME_HPP
 #define SAUROBYTE_GAME_HPP
 
-#include <Saurobyte/EntityPool.hpp>
-#include <Saurobyte/SystemPool.hpp>
-#include <Saurobyte/ScenePool.hpp>
-#include <Saurobyte/MessageCentral.hpp>
+#include <Saurobyte/World.hpp>
 #include <Saurobyte/FrameCounter.hpp>
 #include <Saurobyte/LuaEnvironment.hpp>
 #include <Saurobyte/LuaConfig.hpp>
@@ -73,16 +70,48 @@ namespace Saurobyte
 		Entity& createEntity(const std::string &templateName);
 		Scene& createScene(const std::string &name);
 
+		// Iterating entities by their components, see EntityView
+		template<typename... TTypes> EntityView<TTypes...> view()
+		{
+			return m_world.view<TTypes...>();
+		};
+
 		// Scene managing
 		void changeScene(const std::string &sceneName);
 		Scene* getActiveScene();
 
 		// Message sending
 		void sendMessage(const Message &message);
-		void sendMessage(const std::string &messageName, Entity *entity = nullptr);
-		template<typename TType> void sendMessage(const std::string &messageName, TType data, Entity *entity = nullptr)
+		void sendMessage(const MessageID &messageID, Entity *entity = nullptr);
+		template<typename TType> void sendMessage(const MessageID &messageID, TType data, Entity *entity = nullptr)
+		{
+			sendMessage(MessageData<TType>(messageID, std::move(data), entity));
+		};
+
+		// Queued message sending, queued messages are sent at the start of the next frame
+		void queueMessage(const MessageID &messageID, Entity *entity = nullptr);
+		template<typename TType> void queueMessage(const MessageID &messageID, TType data, Entity *entity = nullptr)
+		{
+			m_world.queueMessage<TType>(messageID, std::move(data), entity);
+		};
+
+		// Posting messages from any thread, posted messages are sent at the start of the next frame
+		bool postMessage(const MessageID &messageID, Entity *entity = nullptr);
+		template<typename TType> bool postMessage(const MessageID &messageID, TType data, Entity *entity = nullptr)
+		{
+			return m_world.postMessage<TType>(messageID, std::move(data), entity);
+		};
+
+		// Sending messages to the entities within a region, see World::sendMessageInRegion
+		void sendMessageInRegion(const MessageID &messageID, const BoundingBox &region);
+		template<typename TType> void sendMessageInRegion(const MessageID &messageID, const BoundingBox &region, TType data)
 		{
-			sendMessage(MessageData<TType>(messageName, data, entity));
+			m_world.sendMessageInRegion<TType>(messageID, region, std::move(data));
+		};
+		void sendMessageInRadius(const MessageID &messageID, const Vector3f &center, float radius);
+		template<typename TType> void sendMessageInRadius(const MessageID &messageID, const Vector3f &center, float radius, TType data)
+		{
+			m_world.sendMessageInRadius<TType>(messageID, center, radius, std::move(data));
 		};
 
 		// Running Lua scripts
@@ -129,6 +158,9 @@ namespace Saurobyte
 		unsigned int getFps() const;
 		float getDelta() const;
 
+		// The world simulated by the engine, further headless worlds may be created independently
+		World& getWorld();
+
 		EntityPool& getEntityPool();
 		SystemPool& getSystemPool();
 		ScenePool& getScenePool();
@@ -141,9 +173,7 @@ namespace Saurobyte
 
 	private:
 
-		EntityPool m_entityPool;
-		SystemPool m_systemPool;
-		ScenePool m_scenePool;
+		World m_world;
 
 		FrameCounter m_frameCounter;
 
@@ -153,8 +183,6 @@ namespace Saurobyte
 		LuaEnvironment m_luaEnvironment;
 		LuaConfig m_luaConfig;
 
-		MessageCentral m_messageCentral;
-
 		/**
 		 * Processes system events and broadcasts a select few as messages.
 		 * @return True if the application shutdown event was not received, false otherwise
@@ -1,126 +1,432 @@
 #include <Saurobyte/Entity.hpp>
-#include <Saurobyte/Engine.hpp>
+#include <Saurobyte/World.hpp>
+#include <Saurobyte/Archetype.hpp>
+#include <Saurobyte/SparseSet.hpp>
 
 namespace Saurobyte
 {
-	Entity::Entity(EntityID id, Engine *engine)
+	const std::size_t Entity::NotSleeping;
+
+	Entity::Entity(EntityID id, World *world)
 		:
+		m_archetype(nullptr),
+		m_row(0),
 		m_isActive(true),
 		m_id(id),
-		m_engine(engine),
+		m_world(world),
+		m_generation(1),
+		m_pendingChanges(0),
+		m_isSleeping(false),
+		m_sleepDuration(-1),
+		m_wakeTime(-1),
+		m_sleepIndex(NotSleeping),
 		m_scene(nullptr)
 	{
 
 	}
 	Entity::~Entity()
 	{
-		m_components.clear();
-		m_luaComponents.clear();
+		if(m_archetype != nullptr)
+			m_archetype->removeRow(m_row);
 	}
 
 	void Entity::addComponent(TypeID id, BaseComponent *component)
 	{
-		// Make sure the component doesn't exist, then add it
-		auto itr = m_components.find(component->getTypeID());
+		// Make sure we're not adding the same component twice
+		if(component == getComponent(component->getTypeID()))
+			return;
 
-		// Due to the nature of unique_ptr, existing components will be
-		// overwrited, so make sure we're not adding the same component twice.
-		if(itr != m_components.end() && component == itr->second.get())
+		CommandBuffer *commands = CommandBuffer::getActive();
+		if(commands != nullptr)
+		{
+			commands->addComponent(*this, component);
 			return;
+		}
+
+		const ComponentType *type = ComponentType::get(component->getTypeID());
+		type->moveFrom(prepareComponent(*type), *component);
+		delete component;
+
+		componentAdded(*type, *getComponent(type->id));
+	}
+	void Entity::addComponentCopy(const BaseComponent &component)
+	{
+		if(&component == getComponent(component.getTypeID()))
+			return;
+
+		CommandBuffer *commands = CommandBuffer::getActive();
+		if(commands != nullptr)
+		{
+			commands->addComponent(*this, component.clone());
+			return;
+		}
+
+		const ComponentType *type = ComponentType::get(component.getTypeID());
+		type->copyConstruct(prepareComponent(*type), component);
+
+		componentAdded(*type, *getComponent(type->id));
+	}
+	void* Entity::prepareComponent(const ComponentType &type)
+	{
+		// Existing components are overwritten, in place
+		void *data = getComponentData(type.id);
+		if(data != nullptr)
+		{
+			type.destroy(data);
+			return data;
+		}
 
-		m_components[component->getTypeID()] = ComponentPtr(component);
+		// Sparse components don't move the other components of the entity
+		if(type.isSparse)
+		{
+			m_sparseComponents.set(type.signatureBit);
+			return m_world->getEntityPool().getSparseSet(type).allocate(*this);
+		}
 
+		Archetype &target = m_world->getEntityPool().getArchetypeWith(m_archetype, type);
+		if(m_archetype != nullptr)
+			m_row = m_archetype->moveRow(m_row, target);
+		else
+			m_row = target.allocateRow(*this);
+
+		m_archetype = &target;
+		return m_archetype->getComponentData(m_row, type.id);
+	}
+	void Entity::componentAdded(const ComponentType &type, BaseComponent &component)
+	{
 		// Save component by name as well, used by Lua
-		m_luaComponents[component->getName()] = component;
+		if(!type.isNamed())
+			ComponentType::setName(type.id, component.getName());
 
-		refresh();
+		// Sparse components only matter to the systems requiring them
+		if(!type.isSparse || m_world->getSystemPool().isRequired(type))
+			refresh();
+	}
+	void Entity::changeComponents(std::vector<ComponentPtr> &added, const std::vector<TypeID> &removed)
+	{
+		EntityPool &entityPool = m_world->getEntityPool();
+
+		// Sparse components are removed on their own, without moving the others
+		bool needsRefresh = false;
+		for(std::size_t i = 0; i < removed.size(); i++)
+		{
+			if(removeSparseComponent(removed[i]))
+				needsRefresh = true;
+		}
+
+		// Walk the cached archetype transitions to the final component setup
+		Archetype *source = m_archetype;
+		Archetype *target = m_archetype;
+		for(std::size_t i = 0; i < removed.size(); i++)
+		{
+			if(target != nullptr && target->hasComponent(removed[i]))
+				target = entityPool.getArchetypeWithout(*target, removed[i]);
+		}
+		for(std::size_t i = 0; i < added.size(); i++)
+		{
+			const ComponentType *type = ComponentType::get(added[i]->getTypeID());
+			if(type->isSparse)
+				continue;
+
+			needsRefresh = true;
+			if(target == nullptr || !target->hasComponent(type->id))
+				target = &entityPool.getArchetypeWith(target, *type);
+		}
+
+		// Move the row once, leaving the memory of new components unconstructed
+		if(target != source)
+		{
+			if(source == nullptr)
+				m_row = target->allocateRow(*this);
+			else if(target == nullptr)
+				source->removeRow(m_row);
+			else
+				m_row = source->moveRow(m_row, *target);
+
+			m_archetype = target;
+			needsRefresh = true;
+		}
+
+		for(std::size_t i = 0; i < added.size(); i++)
+		{
+			const ComponentType *type = ComponentType::get(added[i]->getTypeID());
+			void *data = nullptr;
+
+			// Existing components are overwritten
+			if(type->isSparse)
+			{
+				data = prepareComponent(*type);
+				if(m_world->getSystemPool().isRequired(*type))
+					needsRefresh = true;
+			}
+			else
+			{
+				data = getComponentData(type->id);
+				if(source != nullptr && source->hasComponent(type->id))
+					type->destroy(data);
+			}
+
+			type->moveFrom(data, *added[i]);
+
+			if(!type->isNamed())
+				ComponentType::setName(type->id, added[i]->getName());
+		}
+		added.clear();
+
+		if(needsRefresh)
+			refresh();
 	}
 	void Entity::removeComponent(TypeID id)
 	{
-		auto itr = m_components.find(id);
+		CommandBuffer *commands = CommandBuffer::getActive();
+		if(commands != nullptr)
+		{
+			commands->removeComponent(*this, id);
+			return;
+		}
 
 		// Remove component if it exists
-		if(itr != m_components.end())
+		if(m_archetype != nullptr && m_archetype->hasComponent(id))
 		{
+			Archetype *target = m_world->getEntityPool().getArchetypeWithout(*m_archetype, id);
+			if(target != nullptr)
+				m_row = m_archetype->moveRow(m_row, *target);
+			else
+				m_archetype->removeRow(m_row);
 
-			// Remove from name map as well
-			auto nameItr = m_luaComponents.find(itr->second->getName());
-			if(nameItr != m_luaComponents.end())
-				m_luaComponents.erase(nameItr);
-
-			m_components.erase(itr);
+			m_archetype = target;
 			refresh();
 		}
+		else if(removeSparseComponent(id))
+			refresh();
+	}
+	bool Entity::removeSparseComponent(TypeID id)
+	{
+		SparseSet *sparseSet = findSparseSet(id);
+		if(sparseSet == nullptr)
+			return false;
 
+		sparseSet->remove(m_id);
+		m_sparseComponents.reset(sparseSet->getType().signatureBit);
+
+		return m_world->getSystemPool().isRequired(sparseSet->getType());
+	}
+	SparseSet* Entity::findSparseSet(TypeID id)
+	{
+		if(m_sparseComponents.none())
+			return nullptr;
+
+		SparseSet *sparseSet = m_world->getEntityPool().findSparseSet(id);
+		return sparseSet != nullptr && sparseSet->contains(m_id) ? sparseSet : nullptr;
+	}
+	void* Entity::getComponentData(TypeID id)
+	{
+		void *data = m_archetype == nullptr ? nullptr : m_archetype->getComponentData(m_row, id);
+		if(data == nullptr)
+		{
+			SparseSet *sparseSet = findSparseSet(id);
+			if(sparseSet != nullptr)
+				data = sparseSet->get(m_id);
+		}
+
+		return data;
 	}
 	BaseComponent* const Entity::getComponent(TypeID id)
 	{
-		auto iter = m_components.find(id);
+		BaseComponent *component = m_archetype == nullptr ? nullptr : m_archetype->getComponent(m_row, id);
+		if(component == nullptr)
+		{
+			SparseSet *sparseSet = findSparseSet(id);
+			if(sparseSet != nullptr)
+				component = sparseSet->getType().toBase(sparseSet->get(m_id));
+		}
 
-		return iter == m_components.end() ? nullptr : iter->second.get();
+		return component;
 	}
 	BaseComponent* const Entity::getComponent(const std::string &componentName)
 	{
-		auto iter = m_luaComponents.find(componentName);
+		const ComponentType *type = ComponentType::get(componentName);
 
-		return iter == m_luaComponents.end() ? nullptr : iter->second;
+		return type == nullptr ? nullptr : getComponent(type->id);
 	}
 	bool Entity::hasComponent(TypeID id)
 	{
-		auto iter = m_components.find(id);
-		return iter != m_components.end();
+		return (m_archetype != nullptr && m_archetype->hasComponent(id)) || findSparseSet(id) != nullptr;
 	}
 
 	void Entity::removeAllComponents()
 	{
-		m_components.clear();
-		m_luaComponents.clear();
+		CommandBuffer *commands = CommandBuffer::getActive();
+		if(commands != nullptr)
+		{
+			commands->removeAllComponents(*this);
+			return;
+		}
 
+		clearComponents();
 		refresh();
 	}
+	void Entity::clearComponents()
+	{
+		if(m_archetype != nullptr)
+		{
+			m_archetype->removeRow(m_row);
+			m_archetype = nullptr;
+		}
+
+		EntityPool &entityPool = m_world->getEntityPool();
+		for(std::size_t i = 0; m_sparseComponents.any(); i++)
+		{
+			if(m_sparseComponents.test(i))
+			{
+				entityPool.findSparseSetByBit(i)->remove(m_id);
+				m_sparseComponents.reset(i);
+			}
+		}
+	}
 
 	void Entity::refresh()
 	{
-		m_engine->getEntityPool().refreshEntity(*this);
+		CommandBuffer *commands = CommandBuffer::getActive();
+		if(commands != nullptr)
+			commands->refreshEntity(*this);
+		else
+			m_world->getEntityPool().refreshEntity(*this);
 	}
 	void Entity::kill()
 	{
-		m_engine->getEntityPool().killEntity(*this);
+		CommandBuffer *commands = CommandBuffer::getActive();
+		if(commands != nullptr)
+			commands->killEntity(*this);
+		else
+			m_world->getEntityPool().killEntity(*this);
 	}
 	void Entity::detach()
 	{
-		m_engine->getEntityPool().detachEntity(*this);
+		CommandBuffer *commands = CommandBuffer::getActive();
+		if(commands != nullptr)
+			commands->detachEntity(*this);
+		else
+			m_world->getEntityPool().detachEntity(*this);
 	}
 	void Entity::save(const std::string &templateName)
 	{
-		m_engine->getEntityPool().saveEntity(templateName, *this);
+		m_world->getEntityPool().saveEntity(templateName, *this);
 	}
 	void Entity::setActive(bool active)
 	{
-		m_isActive = active;
+		if(m_isActive != active)
+		{
+			m_isActive = active;
+			processingChanged();
+		}
+	}
+
+	void Entity::sleep()
+	{
+		m_isSleeping = true;
+		m_sleepDuration = -1;
+		m_wakeTime = -1;
+		processingChanged();
+	}
+	void Entity::sleep(const Time &duration)
+	{
+		m_isSleeping = true;
+		m_sleepDuration = duration.asSeconds();
+		m_wakeTime = -1;
+		processingChanged();
+	}
+	void Entity::wake()
+	{
+		if(m_isSleeping)
+		{
+			m_isSleeping = false;
+			m_wakeTime = -1;
+			processingChanged();
+		}
+	}
+	bool Entity::isSleeping() const
+	{
+		return m_isSleeping;
+	}
+	void Entity::processingChanged()
+	{
+		CommandBuffer *commands = CommandBuffer::getActive();
+		if(commands != nullptr)
+			commands->updateProcessing(*this);
+		else
+			m_world->getEntityPool().updateProcessing(*this);
+	}
+
+	void Entity::setParent(Entity *parent)
+	{
+		m_world->getTransformHierarchy().setParent(*this, parent);
+	}
+	Entity* Entity::getParent() const
+	{
+		return m_world->getTransformHierarchy().getParent(*this);
 	}
 
 	void Entity::cloneFrom(Entity &entity)
 	{
-		// Clone the entity copy's components
-		for(auto iter = entity.m_components.begin(); iter != entity.m_components.end(); iter++)
-			this->addComponent(iter->second->getTypeID(), iter->second->clone());
+		if(&entity == this)
+			return;
+
+		// Clone the entity copy's components, copying them straight into storage
+		std::vector<BaseComponent*> components = entity.getComponents();
+		for(std::size_t i = 0; i < components.size(); i++)
+			addComponentCopy(*components[i]);
 
 		refresh();
 	}
 
 	std::size_t Entity::getComponentCount() const
 	{
-		return m_components.size();
+		std::size_t count = m_sparseComponents.count();
+		return m_archetype == nullptr ? count : count + m_archetype->getSignature().size();
 	}
-	ComponentBag& Entity::getComponents()
+	std::vector<BaseComponent*> Entity::getComponents()
 	{
-		return m_components;
+		std::vector<BaseComponent*> components;
+		if(m_archetype != nullptr)
+		{
+			const Archetype::Signature &signature = m_archetype->getSignature();
+			for(std::size_t i = 0; i < signature.size(); i++)
+				components.push_back(m_archetype->getComponent(m_row, signature[i]));
+		}
+
+		EntityPool &entityPool = m_world->getEntityPool();
+		for(std::size_t i = 0; i < m_sparseComponents.size(); i++)
+		{
+			if(m_sparseComponents.test(i))
+			{
+				SparseSet *sparseSet = entityPool.findSparseSetByBit(i);
+				components.push_back(sparseSet->getType().toBase(sparseSet->get(m_id)));
+			}
+		}
+
+		return components;
+	}
+	ComponentSignature Entity::getSignature() const
+	{
+		return m_archetype == nullptr ? m_sparseComponents : m_archetype->getSignatureMask() | m_sparseComponents;
+	}
+	const ComponentSignature& Entity::getSparseSignature() const
+	{
+		return m_sparseComponents;
+	}
+	Archetype* Entity::getArchetype() const
+	{
+		return m_archetype;
 	}
 	EntityID Entity::getID() const
 	{
 		return m_id;
 	}
+	EntityHandle Entity::getHandle() const
+	{
+		return EntityHandle(m_id, m_generation);
+	}
 	bool Entity::isActive() const
 	{
 		return m_isActive;
@@ -129,5 +435,13 @@ namespace Saurobyte
 	{
 		return m_scene != nullptr;
 	}
+	Scene* Entity::getScene() const
+	{
+		return m_scene;
+	}
+	const SystemSignature& Entity::getSystems() const
+	{
+		return m_systems;
+	}
 
 };
\ No newline at end of file
@@ -1,40 +1,78 @@
 #ifndef JL_ENTITY_HPP
 #define JL_ENTITY_HPP
 
-#include <unordered_map>
+#include <vector>
 #include <memory>
 #include <Saurobyte/IdentifierTypes.hpp>
 #include <Saurobyte/Component.hpp>
+#include <Saurobyte/ComponentType.hpp>
+#include <Saurobyte/CommandBuffer.hpp>
+#include <Saurobyte/Time.hpp>
 
 namespace Saurobyte
 {
 
 	typedef std::unique_ptr<BaseComponent> ComponentPtr;
-	typedef std::unordered_map<TypeID, ComponentPtr> ComponentBag;
-	typedef std::unordered_map<std::string, BaseComponent*> LuaComponentBag;
 
-	class Engine;
+	class World;
 	class Scene;
+	class Archetype;
+	class SparseSet;
 	class Entity
 	{
 	private:
 
-		// Entities own their components
-		ComponentBag m_components;
-		LuaComponentBag m_luaComponents;
+		// Components are stored by value in the archetype matching the
+		// component setup of the entity, nullptr if there are no components.
+		Archetype *m_archetype;
+		std::size_t m_row;
+		friend class Archetype;
+
+		// Sparse component types of the entity, stored in the SparseSets of the EntityPool
+		ComponentSignature m_sparseComponents;
 
 		bool m_isActive;
 
 		const EntityID m_id;
-		Engine *const m_engine;
+		World *const m_world;
+
+		// Increased by the EntityPool whenever the entity is killed, see EntityHandle
+		unsigned int m_generation;
+		friend class EntityPool;
+
+		// Changes processed by the EntityPool at the start of the next frame,
+		// collected as flags so repeated requests collapse into one.
+		enum PendingChanges
+		{
+			Kill = 1 << 0, // Strips the entity of components and makes it reusable
+			Refresh = 1 << 1, // Updates the monitoring status of the entity within the systems
+			Processing = 1 << 2 // Moves the entity in or out of system iteration after sleeping, waking or (de)activation
+		};
+		unsigned char m_pendingChanges;
+
+		// Sleep state, see sleep. The requested duration is negative when sleeping until woken, the
+		// wake time is in EntityPool time and the index refers to the sleeping entities of the pool.
+		bool m_isSleeping;
+		float m_sleepDuration;
+		double m_wakeTime;
+		std::size_t m_sleepIndex;
+		static const std::size_t NotSleeping = static_cast<std::size_t>(-1);
+
+		// Schedules moving the entity in or out of system iteration
+		void processingChanged();
 
 		// The scene that the entity is in
 		Scene *m_scene;
 		friend class Scene;
 
+		// Systems processing the entity, one bit per system index
+		SystemSignature m_systems;
+		friend class BaseSystem;
+		friend class SystemPool;
+
 	public:
 
-		explicit Entity(EntityID id, Engine *engine);
+		explicit Entity(EntityID id, World *world);
 		~Entity();
 		
 		// Entities may not be copied, their components can be cloned though
@@ -43,11 +81,26 @@ namespace Saurobyte
 
 		// Sends a request to have the specified component added, it will be processed
 		// at the start of the next frame.
+		// While a CommandBuffer is active on the calling thread (i.e parallel system processing), this
+		// and the other structural changes below are recorded into it and applied once flushed.
 		template<typename TType, typename ...TArgs> void addComponent(TArgs&&... args)
 		{
-			addComponent(TypeIdGrabber::getUniqueTypeID<TType>(), new TType(args...));
+			CommandBuffer *commands = CommandBuffer::getActive();
+			if(commands != nullptr)
+			{
+				commands->addComponent(*this, new TType(std::forward<TArgs>(args)...));
+				return;
+			}
+
+			// Construct the component in place, directly in component storage
+			const ComponentType &type = ComponentType::get<TType>();
+			TType *component = new (prepareComponent(type)) TType(std::forward<TArgs>(args)...);
+			componentAdded(type, *component);
 		};
+		// Moves the component into the entity and deletes the passed in instance
 		void addComponent(TypeID id, BaseComponent *component);
+		// Copies the component into the entity
+		void addComponentCopy(const BaseComponent &component);
 
 		// Sends a request to have the specified component removed, it will be processed
 		// at the start of the next frame.
@@ -59,14 +112,25 @@ namespace Saurobyte
 
 		// Attempts to retrieve the specified component from the entity, returns 'nullptr'
 		// if the component wasen't found. The return value is read-write enabled.
+		// Pointers are valid until the next component change of any entity sharing
+		// the same archetype, so don't hold on to them between frames.
 		template<typename TType> TType* const getComponent()
 		{
-			BaseComponent *comp = getComponent(TypeIdGrabber::getUniqueTypeID<TType>());
-
-			return comp == nullptr ? nullptr : static_cast<TType*>(comp);
+			return static_cast<TType*>(getComponentData(TypeIdGrabber::getUniqueTypeID<TType>()));
 		};
 		BaseComponent* const getComponent(TypeID id);
 
+		// Retrieves a component for writing, marking it as changed so systems filtering on
+		// changes pick it up (see BaseComponent::markChanged). Returns 'nullptr' if not found.
+		template<typename TType> TType* const editComponent()
+		{
+			TType *component = getComponent<TType>();
+			if(component != nullptr)
+				component->markChanged();
+
+			return component;
+		};
+
 		// Used by Lua to get components
 		BaseComponent* const getComponent(const std::string &componentName);
 
@@ -84,9 +148,23 @@ namespace Saurobyte
 		void detach();
 		void save(const std::string &templateName);
 
-		// Activates/deactives the entity for processing
+		// Activates/deactives the entity for processing, inactive entities are taken out
+		// of system iteration at the start of the next frame.
 		void setActive(bool active);
 
+		// Puts the entity to sleep, taking it out of the iteration of all systems at the start of the next
+		// frame so it costs nothing per frame. Sleeping entities are woken by wake, by messages sent along
+		// with the entity, by EntityPool::wakeEntitiesNear or, optionally, once the duration has passed.
+		void sleep();
+		void sleep(const Time &duration);
+		void wake();
+		bool isSleeping() const;
+
+		// Attaches the entity to a parent, making its transform relative to that of the parent.
+		// Both entities need a TransformComponent, see TransformHierarchy.
+		void setParent(Entity *parent);
+		Entity* getParent() const;
+
 		// Clones the components of the target entity into this entity. Existing
 		// components that conflicts will be overwritten, others will remain
 		// untouched.
@@ -94,10 +172,22 @@ namespace Saurobyte
 
 		std::size_t getComponentCount() const;
 
-		// Returns a read-write enabled map of all the internal components
-		ComponentBag& getComponents();
+		// Returns read-write enabled pointers to all the internal components
+		std::vector<BaseComponent*> getComponents();
+
+		// Returns the signature of the component setup of the entity, with one
+		// bit set per component type (see ComponentType::getSignatureBit).
+		ComponentSignature getSignature() const;
+		// Returns the part of the signature made up of sparse component types
+		const ComponentSignature& getSparseSignature() const;
+
+		// Returns the archetype storing the components of this entity, nullptr
+		// if the entity has no components other than sparse ones.
+		Archetype* getArchetype() const;
 
 		EntityID getID() const;
+		// Returns a handle to the entity, which becomes invalid once the entity has been killed
+		EntityHandle getHandle() const;
 		// Whether or not the Entity is active, inactive entities do not
 		// get processed at all.
 		bool isActive() const;
@@ -107,6 +197,36 @@ namespace Saurobyte
 		 * @return Whether or not entity is attached to a scenee
 		 */
 		bool inScene() const;
+		/**
+		 * Returns the scene the entity is attached to, nullptr if it isn't in a scene
+		 */
+		Scene* getScene() const;
+
+		/**
+		 * Returns the systems processing this entity, with one bit set per system (see BaseSystem::getSystemIndex)
+		 */
+		const SystemSignature& getSystems() const;
+
+	private:
+
+		// Moves the entity into an archetype (or sparse set) with room for the specified
+		// component type and returns the (unconstructed) memory of the component.
+		void* prepareComponent(const ComponentType &type);
+		void componentAdded(const ComponentType &type, BaseComponent &component);
+
+		void* getComponentData(TypeID id);
+
+		// Retrieves the set holding a sparse component of the entity, nullptr if it has no such component
+		SparseSet* findSparseSet(TypeID id);
+		// Removes a sparse component if the entity has it, returns whether or not systems need to know
+		bool removeSparseComponent(TypeID id);
+
+		// Applies a batch of component changes with a single archetype move. Components in
+		// 'added' are moved into the entity, the types in 'removed' must not be among them.
+		void changeComponents(std::vector<ComponentPtr> &added, const std::vector<TypeID> &removed);
+		// Strips the entity of all of its components without refreshing it
+		void clearComponents();
+		friend class CommandBuffer;
 	};
 };
 
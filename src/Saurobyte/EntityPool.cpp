@@ -1,38 +1,48 @@
 #include <Saurobyte/EntityPool.hpp>
-#include <Saurobyte/Engine.hpp>
+#include <Saurobyte/World.hpp>
+#include <Saurobyte/Components/TransformComponent.hpp>
+#include <Saurobyte/Logger.hpp>
+#include <algorithm>
 
 namespace Saurobyte
 {
 
-	EntityPool::EntityPool(Engine *engine)
+	EntityPool::EntityPool(World *world)
 		:
-		m_engine(engine)
+		m_time(0),
+		m_world(world)
 	{
 
 	}
 	EntityPool::~EntityPool()
 	{
-		// Push all pending deletes to the spare pool
-		frameCleanup();
+		// Pending actions are dropped rather than processed, the system and scene
+		// pools are destroyed before the entity pool.
+		m_dirtyEntities.clear();
 
-		m_sparePool.clear();
+		m_freeSlots.clear();
 		m_entityPool.clear();
 		m_entityTemplates.clear();
+		m_archetypes.clear();
+		m_sparseSets.clear();
 	}
 
 	Entity& EntityPool::createEntity()
 	{
 		Entity *newEntity = nullptr;
-		if(m_sparePool.size() > 0)
+		if(!m_freeSlots.empty())
 		{
-			newEntity = m_sparePool.back();
+			// Reuse a slot, its generation was increased when the previous entity was killed
+			newEntity = m_entityPool[m_freeSlots.back()].get();
 			newEntity->setActive(true);
-			m_sparePool.pop_back();
+			m_freeSlots.pop_back();
 		}
 		else
-			newEntity = new Entity(m_entityPool.size(), m_engine);
+		{
+			newEntity = new Entity(m_entityPool.size(), m_world);
+			m_entityPool.push_back(EntityPtr(newEntity));
+		}
 
-		m_entityPool.push_back(EntityPtr(newEntity));
 		return *newEntity;
 	}
 	Entity& EntityPool::createEntity(const std::string &templateName)
@@ -44,25 +54,89 @@ namespace Saurobyte
 		if(itr != m_entityTemplates.end())
 		{
 			for(std::size_t i = 0; i < itr->second.size(); i++)
-				ent.addComponent(itr->second[i]->getTypeID(), itr->second[i]->clone());
+				ent.addComponentCopy(*itr->second[i]);
 		}
 
 		return ent;
 	}
+	std::vector<EntityHandle> EntityPool::createEntities(const std::string &templateName, std::size_t count)
+	{
+		std::vector<EntityHandle> handles;
+		handles.reserve(count);
+
+		auto itr = m_entityTemplates.find(templateName);
+		std::vector<ComponentPtr> *components = itr == m_entityTemplates.end() ? nullptr : &itr->second;
+
+		// All entities end up in the same archetype, so look it up once. Sparse
+		// components are kept out of archetypes and added one entity at a time.
+		Archetype *archetype = nullptr;
+		std::vector<const BaseComponent*> sparseComponents;
+		for(std::size_t i = 0; components != nullptr && i < components->size(); i++)
+		{
+			const ComponentType *type = ComponentType::get((*components)[i]->getTypeID());
+			if(type->isSparse)
+				sparseComponents.push_back((*components)[i].get());
+			else
+				archetype = &getArchetypeWith(archetype, *type);
+		}
+
+		m_entityPool.reserve(m_entityPool.size() + count - std::min(count, m_freeSlots.size()));
+
+		std::size_t firstRow = 0;
+		if(archetype != nullptr)
+		{
+			firstRow = archetype->getEntityCount();
+			archetype->reserve(firstRow + count);
+		}
+
+		for(std::size_t i = 0; i < count; i++)
+		{
+			Entity &entity = createEntity();
+			if(archetype != nullptr)
+			{
+				entity.m_archetype = archetype;
+				entity.m_row = archetype->allocateRow(entity);
+			}
+
+			for(std::size_t j = 0; j < sparseComponents.size(); j++)
+				entity.addComponentCopy(*sparseComponents[j]);
+
+			markDirty(entity, Entity::Refresh);
+			handles.push_back(entity.getHandle());
+		}
+
+		// The new rows are contiguous, fill them one column at a time
+		for(std::size_t i = 0; archetype != nullptr && i < components->size(); i++)
+		{
+			if(archetype->hasComponent((*components)[i]->getTypeID()))
+				archetype->fillRows(firstRow, count, *(*components)[i]);
+		}
+
+		return handles;
+	}
 	void EntityPool::killEntity(Entity &entity)
 	{
-		// Push kill request
-		m_pendingActions.push_back({&entity, EntityActions::Kill});
+		markDirty(entity, Entity::Kill);
 	}
 	void EntityPool::refreshEntity(Entity &entity)
 	{
-		// Push refresh request
-		m_pendingActions.push_back({&entity, EntityActions::Refresh});
+		markDirty(entity, Entity::Refresh);
 	}
 	void EntityPool::detachEntity(Entity &entity)
 	{
-		// Push detach request
-		m_pendingActions.push_back({&entity, EntityActions::Detach});
+		// Refreshing removes entities from systems when they are not in the active scene
+		markDirty(entity, Entity::Refresh);
+	}
+	void EntityPool::updateProcessing(Entity &entity)
+	{
+		markDirty(entity, Entity::Processing);
+	}
+	void EntityPool::markDirty(Entity &entity, unsigned char changes)
+	{
+		if(entity.m_pendingChanges == 0)
+			m_dirtyEntities.push_back(&entity);
+
+		entity.m_pendingChanges |= changes;
 	}
 	void EntityPool::saveEntity(const std::string &templateName, Entity &entity)
 	{
@@ -72,57 +146,295 @@ namespace Saurobyte
 			findItr->second.clear();
 
 		std::vector<ComponentPtr>& componentSetup = m_entityTemplates[templateName];
-		for(auto itr = entity.getComponents().begin(); itr != entity.getComponents().end(); itr++)
-			componentSetup.push_back(ComponentPtr(itr->second->clone()));
+		std::vector<BaseComponent*> components = entity.getComponents();
+		for(std::size_t i = 0; i < components.size(); i++)
+			componentSetup.push_back(ComponentPtr(components[i]->clone()));
 	}
 
 	void EntityPool::frameCleanup()
 	{
-		for(std::size_t i = 0; i < m_pendingActions.size(); i++)
+		SystemPool &systemPool = m_world->getSystemPool();
+		SpatialGrid &spatialGrid = m_world->getSpatialGrid();
+
+		m_time += m_world->getDelta();
+		wakeTimedEntities();
+
+		// Entities changed by observers while delivering changes are handled in another round
+		while(!m_dirtyEntities.empty())
 		{
-			Entity *entity = m_pendingActions[i].entity;
-			EntityActions action = m_pendingActions[i].action;
+			m_cleanupEntities.swap(m_dirtyEntities);
 
-			if(action == EntityActions::Kill)
+			for(std::size_t i = 0; i < m_cleanupEntities.size(); i++)
 			{
-					// Detach entity from other systems first since we might
-					// want to do use data from the components just before they are removed.
-					m_engine->getSystemPool().removeEntityFromSystems(*entity, true);
-					m_engine->getScenePool().detachFromAllScenes(*entity);
+				Entity *entity = m_cleanupEntities[i];
+				unsigned char changes = entity->m_pendingChanges;
+				entity->m_pendingChanges = 0;
 
-					// Strip entity of components, deactivate it and push
-					// it into spare pool
-					entity->removeAllComponents(); // This call refreshes the entity as well
-					entity->setActive(false);
+				if(changes & Entity::Kill)
+				{
+					// Detach entity from systems and scenes first, its components are
+					// removed once the systems have been notified.
+					systemPool.removeEntityFromSystems(*entity, true);
+					m_world->getScenePool().detachFromAllScenes(*entity);
+					m_killedEntities.push_back(entity);
+					continue;
+				}
 
+				if(changes & Entity::Processing)
+					applyProcessing(*entity);
 
-					m_sparePool.push_back(entity);
-			}
-			else if(action == EntityActions::Refresh)
-			{
-				Scene* activeScene = m_engine->getScenePool().getActiveScene();
+				if(changes & Entity::Refresh)
+				{
+					spatialGrid.refreshEntity(*entity);
+
+					// Match the entity against the systems once, using its final component
+					// setup. Entities outside of the active scene are removed from them.
+					Scene *activeScene = m_world->getScenePool().getActiveScene();
+					if(activeScene != nullptr && activeScene->contains(*entity))
+					{
+						// Entities created or changed together share their component setup,
+						// so match the whole run against the systems at once.
+						m_refreshBatch.assign(1, entity);
+						while(i + 1 < m_cleanupEntities.size())
+						{
+							Entity *next = m_cleanupEntities[i + 1];
+							if(next->m_pendingChanges != Entity::Refresh ||
+								next->getArchetype() != entity->getArchetype() ||
+								next->getSparseSignature() != entity->getSparseSignature() ||
+								!activeScene->contains(*next))
+								break;
 
-				// Refresh entity monitoring status if it's in the active scene
-				if(activeScene != nullptr && activeScene->contains(*entity))
-					m_engine->getSystemPool().refreshEntity(*entity);
+							next->m_pendingChanges = 0;
+							spatialGrid.refreshEntity(*next);
+							m_refreshBatch.push_back(next);
+							i++;
+						}
+
+						systemPool.refreshEntities(m_refreshBatch);
+					}
+					else
+						systemPool.removeEntityFromSystems(*entity, false);
+				}
 			}
-			else if(action == EntityActions::Detach)
+			m_cleanupEntities.clear();
+
+			// Killed entities still have their components while the systems are notified
+			systemPool.deliverChanges();
+
+			for(std::size_t i = 0; i < m_killedEntities.size(); i++)
 			{
-				// Detach entity from all systems
-				m_engine->getSystemPool().removeEntityFromSystems(*entity, false);
+				Entity *entity = m_killedEntities[i];
+
+				// Strip entity of components, deactivate it and free its slot. It's no longer in any
+				// system, so neither of that may mark it dirty again.
+				spatialGrid.removeEntity(*entity);
+				entity->clearComponents();
+				entity->m_isActive = false;
+				entity->m_isSleeping = false;
+				entity->m_wakeTime = -1;
+				stopTracking(*entity);
+				entity->m_pendingChanges = 0;
+
+				// Invalidate handles to the entity and make its slot available,
+				// skipping generation 0 which is reserved for invalid handles.
+				if(++entity->m_generation == 0)
+					entity->m_generation = 1;
+
+				m_freeSlots.push_back(entity->getID());
 			}
+			m_killedEntities.clear();
+		}
+	}
 
+	void EntityPool::applyProcessing(Entity &entity)
+	{
+		if(entity.m_isSleeping && entity.m_sleepIndex == Entity::NotSleeping)
+		{
+			entity.m_sleepIndex = m_sleepingEntities.size();
+			m_sleepingEntities.push_back(&entity);
+		}
+		else if(!entity.m_isSleeping)
+			stopTracking(entity);
 
+		// Outdated timers are recognized by their wake time, so they don't need to be removed
+		if(entity.m_isSleeping && entity.m_sleepDuration >= 0)
+		{
+			entity.m_wakeTime = m_time + entity.m_sleepDuration;
+			entity.m_sleepDuration = -1;
+
+			m_sleepTimers.push_back({entity.m_wakeTime, entity.getHandle()});
+			std::push_heap(m_sleepTimers.begin(), m_sleepTimers.end());
 		}
-		m_pendingActions.clear();
+
+		m_world->getSystemPool().updateProcessing(entity);
+	}
+	void EntityPool::stopTracking(Entity &entity)
+	{
+		if(entity.m_sleepIndex == Entity::NotSleeping)
+			return;
+
+		Entity *last = m_sleepingEntities.back();
+		m_sleepingEntities[entity.m_sleepIndex] = last;
+		last->m_sleepIndex = entity.m_sleepIndex;
+		m_sleepingEntities.pop_back();
+
+		entity.m_sleepIndex = Entity::NotSleeping;
+	}
+	void EntityPool::wakeTimedEntities()
+	{
+		while(!m_sleepTimers.empty() && m_sleepTimers.front().wakeTime <= m_time)
+		{
+			SleepTimer timer = m_sleepTimers.front();
+			std::pop_heap(m_sleepTimers.begin(), m_sleepTimers.end());
+			m_sleepTimers.pop_back();
+
+			Entity *entity = getEntity(timer.entity);
+			if(entity != nullptr && entity->isSleeping() && entity->m_wakeTime == timer.wakeTime)
+				entity->wake();
+		}
+	}
+
+	void EntityPool::wakeEntitiesNear(const Vector3f &position, float radius)
+	{
+		// Waking only marks the entities, so the list stays intact while iterating it
+		for(std::size_t i = 0; i < m_sleepingEntities.size(); i++)
+		{
+			Entity *entity = m_sleepingEntities[i];
+			TransformComponent *transform = entity->getComponent<TransformComponent>();
+			if(transform != nullptr && transform->getPosition().distance(position) <= radius)
+				entity->wake();
+		}
+	}
+	std::size_t EntityPool::getSleepingEntityCount() const
+	{
+		return m_sleepingEntities.size();
+	}
+
+	Archetype& EntityPool::findArchetype(const std::vector<const ComponentType*> &componentTypes)
+	{
+		Archetype::Signature signature;
+		for(std::size_t i = 0; i < componentTypes.size(); i++)
+			signature.push_back(componentTypes[i]->id);
+		std::sort(signature.begin(), signature.end());
+
+		auto itr = m_archetypeLookup.find(signature);
+		if(itr != m_archetypeLookup.end())
+			return *itr->second;
+
+		Archetype *archetype = new Archetype(componentTypes);
+		m_archetypes.push_back(ArchetypePtr(archetype));
+		m_archetypeLookup[signature] = archetype;
+
+		for(auto queryItr = m_queries.begin(); queryItr != m_queries.end(); queryItr++)
+			queryItr->second->addArchetype(*archetype);
+
+		return *archetype;
+	}
+	Archetype& EntityPool::getArchetypeWith(Archetype *archetype, const ComponentType &type)
+	{
+		// Transitions are cached in the archetype graph, so lookups only happen once
+		std::unordered_map<TypeID, Archetype*> &edges = archetype == nullptr ? m_rootEdges : archetype->m_addEdges;
+		auto itr = edges.find(type.id);
+		if(itr != edges.end())
+			return *itr->second;
+
+		std::vector<const ComponentType*> componentTypes;
+		if(archetype != nullptr)
+			componentTypes = archetype->getComponentTypes();
+		componentTypes.push_back(&type);
+
+		Archetype &target = findArchetype(componentTypes);
+		edges[type.id] = &target;
+		if(archetype != nullptr)
+			target.m_removeEdges[type.id] = archetype;
+
+		return target;
+	}
+	Archetype* EntityPool::getArchetypeWithout(Archetype &archetype, TypeID id)
+	{
+		auto itr = archetype.m_removeEdges.find(id);
+		if(itr != archetype.m_removeEdges.end())
+			return itr->second;
+
+		std::vector<const ComponentType*> componentTypes;
+		for(std::size_t i = 0; i < archetype.getComponentTypes().size(); i++)
+		{
+			if(archetype.getComponentTypes()[i]->id != id)
+				componentTypes.push_back(archetype.getComponentTypes()[i]);
+		}
+
+		Archetype *target = componentTypes.empty() ? nullptr : &findArchetype(componentTypes);
+		archetype.m_removeEdges[id] = target;
+		if(target != nullptr)
+			target->m_addEdges[id] = &archetype;
+
+		return target;
+	}
+	const std::vector<EntityPool::ArchetypePtr>& EntityPool::getArchetypes() const
+	{
+		return m_archetypes;
+	}
+	SparseSet& EntityPool::getSparseSet(const ComponentType &type)
+	{
+		auto itr = m_sparseLookup.find(type.id);
+		if(itr != m_sparseLookup.end())
+			return *itr->second;
+
+		if(m_sparseSets.size() <= type.signatureBit)
+			m_sparseSets.resize(type.signatureBit + 1);
+
+		SparseSet *sparseSet = new SparseSet(type);
+		m_sparseSets[type.signatureBit] = std::unique_ptr<SparseSet>(sparseSet);
+		m_sparseLookup[type.id] = sparseSet;
+
+		return *sparseSet;
+	}
+	SparseSet* EntityPool::findSparseSet(TypeID id)
+	{
+		auto itr = m_sparseLookup.find(id);
+		return itr == m_sparseLookup.end() ? nullptr : itr->second;
+	}
+	SparseSet* EntityPool::findSparseSetByBit(std::size_t signatureBit)
+	{
+		return signatureBit < m_sparseSets.size() ? m_sparseSets[signatureBit].get() : nullptr;
+	}
+	const EntityQuery& EntityPool::getQuery(const std::vector<TypeID> &ids)
+	{
+		// Sparse components live outside of archetypes, a query including them would never match
+		for(std::size_t i = 0; i < ids.size(); i++)
+		{
+			const ComponentType *type = ComponentType::get(ids[i]);
+			if(type != nullptr && type->isSparse)
+				SAUROBYTE_FATAL_LOG("Component type ", type->typeName, " is stored sparsely and can't be queried, use getSparseSet instead");
+		}
+
+		ComponentSignature signature = ComponentType::createSignature(ids);
+
+		std::unique_ptr<EntityQuery> &query = m_queries[signature];
+		if(!query)
+		{
+			query = std::unique_ptr<EntityQuery>(new EntityQuery(signature));
+			for(std::size_t i = 0; i < m_archetypes.size(); i++)
+				query->addArchetype(*m_archetypes[i]);
+		}
+
+		return *query;
 	}
 
 	Entity& EntityPool::getEntity(EntityID id)
 	{
 		return *m_entityPool.at(id);
 	}
+	Entity* EntityPool::getEntity(const EntityHandle &handle)
+	{
+		return isValid(handle) ? m_entityPool[handle.id].get() : nullptr;
+	}
+	bool EntityPool::isValid(const EntityHandle &handle) const
+	{
+		return handle.id < m_entityPool.size() && m_entityPool[handle.id]->m_generation == handle.generation;
+	}
 	std::size_t EntityPool::getEntityCount() const
 	{
-		return m_entityPool.size();
+		return m_entityPool.size() - m_freeSlots.size();
 	}
 };
\ No newline at end of file
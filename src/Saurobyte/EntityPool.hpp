@@ -27,64 +27,197 @@
 #define SAUROBYTE_ENTITYIDPOOL_HPP
 
 #include <unordered_map>
+#include <map>
 #include <vector>
 #include <string>
 #include <memory>
 #include <Saurobyte/IdentifierTypes.hpp>
 #include <Saurobyte/Entity.hpp>
+#include <Saurobyte/Archetype.hpp>
+#include <Saurobyte/SparseSet.hpp>
+#include <Saurobyte/EntityView.hpp>
+#include <Saurobyte/Math/Vector3.hpp>
 
 namespace Saurobyte
 {
-	class Engine;
+	class World;
 	class EntityPool
 	{	
 	private:
 
 		typedef std::unique_ptr<Entity> EntityPtr;
 
+		// Component storage, declared before the entities since entities
+		// release their rows when destroyed.
+		std::vector<std::unique_ptr<Archetype> > m_archetypes;
+		std::map<Archetype::Signature, Archetype*> m_archetypeLookup;
+
+		// Archetypes of entities going from no components to a single component
+		std::unordered_map<TypeID, Archetype*> m_rootEdges;
+
+		// Storage of sparse component types, indexed by signature bit and looked up by type
+		std::vector<std::unique_ptr<SparseSet> > m_sparseSets;
+		std::unordered_map<TypeID, SparseSet*> m_sparseLookup;
+
+		// Cached queries of the views handed out so far, kept up to date as archetypes are created
+		std::unordered_map<ComponentSignature, std::unique_ptr<EntityQuery> > m_queries;
+
+		// Entity slots indexed by EntityID, slots of killed entities are reused
 		std::vector<EntityPtr> m_entityPool;
 		std::unordered_map<std::string, std::vector<ComponentPtr> > m_entityTemplates;
 
-		// Pointers to entities that are available for reuse
-		std::vector<Entity*> m_sparePool;
+		// Slots of killed entities that are available for reuse
+		std::vector<EntityID> m_freeSlots;
 
-		enum EntityActions
-		{
-			Kill, // Kills the entity, stripping it of components and making it reusable
-			Refresh, // Refreshes the monitoring status of the entity within the systems
-			Detach // Removes entity from all systems
-		};
-		struct EntityAction
+		// Entities with pending changes (see Entity::PendingChanges), every
+		// entity is added once per frame regardless of how much it changes.
+		std::vector<Entity*> m_dirtyEntities;
+
+		// Flags the entity for processing at the start of the next frame
+		void markDirty(Entity &entity, unsigned char changes);
+
+		// Consecutive dirty entities sharing a component setup, refreshed together
+		std::vector<Entity*> m_refreshBatch;
+
+		// Dirty entities handled by the current round of frameCleanup, and the entities
+		// killed in it which are recycled once systems have been notified.
+		std::vector<Entity*> m_cleanupEntities;
+		std::vector<Entity*> m_killedEntities;
+
+		// Seconds passed so far, advanced once per frame by frameCleanup
+		double m_time;
+
+		// Entities taken out of system iteration by Entity::sleep
+		std::vector<Entity*> m_sleepingEntities;
+
+		// Entities sleeping for a certain duration, as a min-heap on the wake time
+		struct SleepTimer
 		{
-			Entity *entity;
-			EntityActions action;
+			double wakeTime;
+			EntityHandle entity;
+
+			bool operator<(const SleepTimer &rhs) const { return wakeTime > rhs.wakeTime; };
 		};
-		std::vector<EntityAction> m_pendingActions;
+		std::vector<SleepTimer> m_sleepTimers;
+
+		// Applies the sleep and activation state of the entity to the pool and systems
+		void applyProcessing(Entity &entity);
+		void stopTracking(Entity &entity);
+		void wakeTimedEntities();
+
+		World *const m_world;
 
-		Engine *const m_engine;
+		Archetype& findArchetype(const std::vector<const ComponentType*> &componentTypes);
 
 	public:
 
-		EntityPool(Engine *engine);
+		typedef std::unique_ptr<Archetype> ArchetypePtr;
+
+		EntityPool(World *world);
 		~EntityPool();
 
 		// Create empty entity or create by template
 		Entity& createEntity();
 		Entity& createEntity(const std::string &templateName);
 
+		/**
+		 * Creates a batch of entities from a template. Storage is reserved up front and every component
+		 * of the template is copied into all entities at once, the entities are refreshed as a batch.
+		 * @param  templateName The name of the template, see saveEntity. Empty entities are created if it doesn't exist
+		 * @param  count        Amount of entities to create
+		 * @return              Handles of the created entities
+		 */
+		std::vector<EntityHandle> createEntities(const std::string &templateName, std::size_t count);
+
 		// Kills the entity, stripping it of components and recycling it
 		void killEntity(Entity &entity);
 		// Refreshes the entity, updating its monitoring status with systems
 		void refreshEntity(Entity &entity);
 		// Detaches the entity from all systems
 		void detachEntity(Entity &entity);
+		// Moves the entity in or out of system iteration at the start of the next frame, see Entity::sleep
+		void updateProcessing(Entity &entity);
 		// Saves the component setup of an entity and stores it by a string name
 		void saveEntity(const std::string &templateName, Entity &entity);
 
-		// Retrieves an entity by id, returns null if it could not be found
+		// Retrieves the entity in the slot of the specified id
 		Entity& getEntity(EntityID id);
+
+		/**
+		 * Retrieves the entity referenced by a handle
+		 * @param  handle The entity handle, see Entity::getHandle
+		 * @return        The entity, nullptr if it has been killed since the handle was retrieved
+		 */
+		Entity* getEntity(const EntityHandle &handle);
+		bool isValid(const EntityHandle &handle) const;
+
+		// Returns the amount of entities that have not been killed
 		std::size_t getEntityCount() const;
 
+		/**
+		 * Wakes sleeping entities with a TransformComponent close to a position, i.e around the player or
+		 * any other awake entity that sleeping entities should react to. Only sleeping entities are visited.
+		 * @param position The position to wake entities around
+		 * @param radius   The distance within which entities are woken
+		 */
+		void wakeEntitiesNear(const Vector3f &position, float radius);
+		std::size_t getSleepingEntityCount() const;
+
+		/**
+		 * Retrieves the archetype holding the components of 'archetype' with the specified type added, creating it if needed
+		 * @param  archetype The archetype to extend, nullptr for entities without components
+		 * @param  type      The component type to add
+		 * @return           The resulting archetype
+		 */
+		Archetype& getArchetypeWith(Archetype *archetype, const ComponentType &type);
+		/**
+		 * Retrieves the archetype holding the components of 'archetype' with the specified type removed, creating it if needed
+		 * @param  archetype The archetype to reduce
+		 * @param  id        The component type to remove
+		 * @return           The resulting archetype, nullptr if no components would remain
+		 */
+		Archetype* getArchetypeWithout(Archetype &archetype, TypeID id);
+
+		/**
+		 * Returns all archetypes created so far, allowing component columns to be iterated linearly. Use
+		 * Archetype::hasComponents to find those relevant for a certain component combination.
+		 */
+		const std::vector<ArchetypePtr>& getArchetypes() const;
+
+		/**
+		 * Retrieves the storage of a sparse component type (see ComponentReflection::sparseStorage), creating it on first use
+		 * @param  type The component type, which must be sparse
+		 * @return      The storage, valid for the lifetime of the pool
+		 */
+		SparseSet& getSparseSet(const ComponentType &type);
+		template<typename TType> SparseSet& getSparseSet()
+		{
+			return getSparseSet(ComponentType::get<TType>());
+		};
+		/**
+		 * Retrieves the storage of a sparse component type by type or signature bit, nullptr if no
+		 * component of the type has been added yet
+		 */
+		SparseSet* findSparseSet(TypeID id);
+		SparseSet* findSparseSetByBit(std::size_t signatureBit);
+
+		/**
+		 * Retrieves the cached query of a component combination, creating it on first use. Sparse component
+		 * types can't be queried, iterate their SparseSet instead (see getSparseSet).
+		 * @param  ids The component types an entity must have to match the query
+		 * @return     The query, valid for the lifetime of the pool
+		 */
+		const EntityQuery& getQuery(const std::vector<TypeID> &ids);
+
+		/**
+		 * Retrieves a view of all entities having the specified components, see EntityView
+		 */
+		template<typename... TTypes> EntityView<TTypes...> view()
+		{
+			// Registering the types up front lets getQuery tell sparse ones apart
+			return EntityView<TTypes...>(getQuery({ComponentType::get<TTypes>().id...}));
+		};
+
 		void frameCleanup();
 
 	};
@@ -0,0 +1,60 @@
+/*
+
+	The MIT License (MIT)
+
+	Copyright (c) 2014 by Jakob Larsson
+
+	Permission is hereby granted, free of charge, to any person obtaining 
+	a copy of this software and associated documentation files (the "Software"), 
+	to deal in the Software without restriction, including without limitation the 
+	rights to use, copy, modify, merge, publish, distribute, sublicense, and/or 
+	sell copies of the Software, and to permit persons to whom the Software is 
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in 
+	all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+	IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+#include <Saurobyte/EntityView.hpp>
+
+namespace Saurobyte
+{
+	EntityQuery::EntityQuery(const ComponentSignature &signature)
+		:
+		m_signature(signature)
+	{
+
+	}
+
+	void EntityQuery::addArchetype(Archetype &archetype)
+	{
+		if((archetype.getSignatureMask() & m_signature) == m_signature)
+			m_archetypes.push_back(&archetype);
+	}
+
+	const std::vector<Archetype*>& EntityQuery::getArchetypes() const
+	{
+		return m_archetypes;
+	}
+	const ComponentSignature& EntityQuery::getSignature() const
+	{
+		return m_signature;
+	}
+
+	std::size_t EntityQuery::getEntityCount() const
+	{
+		std::size_t count = 0;
+		for(std::size_t i = 0; i < m_archetypes.size(); i++)
+			count += m_archetypes[i]->getEntityCount();
+
+		return count;
+	}
+};
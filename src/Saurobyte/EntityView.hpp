@@ -0,0 +1,215 @@
+/*
+
+	The MIT License (MIT)
+
+	Copyright (c) 2014 by Jakob Larsson
+
+	Permission is hereby granted, free of charge, to any person obtaining 
+	a copy of this software and associated documentation files (the "Software"), 
+	to deal in the Software without restriction, including without limitation the 
+	rights to use, copy, modify, merge, publish, distribute, sublicense, and/or 
+	sell copies of the Software, and to permit persons to whom the Software is 
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in 
+	all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+	IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+#ifndef SAUROBYTE_ENTITY_VIEW_HPP
+#define SAUROBYTE_ENTITY_VIEW_HPP
+
+#include <Saurobyte/Archetype.hpp>
+#include <Saurobyte/ComponentType.hpp>
+#include <Saurobyte/NonCopyable.hpp>
+#include <iterator>
+#include <vector>
+
+namespace Saurobyte
+{
+	class Entity;
+
+	/*
+		EntityQuery
+
+		Cached set of archetypes holding a certain combination of component types.
+		Queries are owned by the EntityPool, which adds archetypes to them as they
+		are created, so a query never has to look at entities one by one.
+
+	*/
+	class EntityQuery : public NonCopyable
+	{
+	public:
+
+		explicit EntityQuery(const ComponentSignature &signature);
+
+		/**
+		 * Adds the archetype to the query if it holds all of the queried component types
+		 * @param archetype The archetype to test
+		 */
+		void addArchetype(Archetype &archetype);
+
+		const std::vector<Archetype*>& getArchetypes() const;
+		const ComponentSignature& getSignature() const;
+
+		// Returns the amount of entities currently matching the query
+		std::size_t getEntityCount() const;
+
+	private:
+
+		ComponentSignature m_signature;
+		std::vector<Archetype*> m_archetypes;
+	};
+
+	/*
+		EntityView
+
+		Iterates all entities having a certain combination of components, without
+		requiring a system. Retrieved through EntityPool::view or Engine::view:
+
+			for(Entity &entity : engine.view<TransformComponent, MeshComponent>())
+				...
+
+			engine.view<TransformComponent, MeshComponent>().each(
+				[] (Entity &entity, TransformComponent &transform, MeshComponent &mesh) { ... });
+
+		Views are cheap to copy and never allocate when iterated. Adding or removing
+		components while iterating moves entities between rows, so such changes
+		should be deferred with a CommandBuffer. Sparse component types aren't
+		kept in archetypes and can't be viewed, see EntityPool::getSparseSet.
+
+	*/
+	template<typename... TTypes> class EntityView
+	{
+	public:
+
+		class Iterator : public std::iterator<std::forward_iterator_tag, Entity>
+		{
+		public:
+
+			Iterator(const std::vector<Archetype*> &archetypes, std::size_t archetype)
+				:
+				m_archetypes(&archetypes),
+				m_archetype(archetype),
+				m_row(0)
+			{
+				skipEmpty();
+			};
+
+			Entity& operator*() const
+			{
+				return (*m_archetypes)[m_archetype]->getEntity(m_row);
+			};
+			Entity* operator->() const
+			{
+				return &**this;
+			};
+
+			Iterator& operator++()
+			{
+				m_row++;
+				skipEmpty();
+				return *this;
+			};
+			Iterator operator++(int)
+			{
+				Iterator previous = *this;
+				++*this;
+				return previous;
+			};
+
+			bool operator==(const Iterator &rhs) const
+			{
+				return m_archetype == rhs.m_archetype && m_row == rhs.m_row;
+			};
+			bool operator!=(const Iterator &rhs) const
+			{
+				return !(*this == rhs);
+			};
+
+		private:
+
+			const std::vector<Archetype*> *m_archetypes;
+			std::size_t m_archetype;
+			std::size_t m_row;
+
+			// Moves on to the next archetype once the rows of the current one run out
+			void skipEmpty()
+			{
+				while(m_archetype < m_archetypes->size() && m_row >= (*m_archetypes)[m_archetype]->getEntityCount())
+				{
+					m_archetype++;
+					m_row = 0;
+				}
+			};
+		};
+
+		explicit EntityView(const EntityQuery &query)
+			:
+			m_query(&query)
+		{
+
+		};
+
+		Iterator begin() const
+		{
+			return Iterator(m_query->getArchetypes(), 0);
+		};
+		Iterator end() const
+		{
+			return Iterator(m_query->getArchetypes(), m_query->getArchetypes().size());
+		};
+
+		/**
+		 * Calls a function for every entity in the view, iterating the component columns directly
+		 * @param func Function taking the entity followed by references to the viewed components
+		 */
+		template<typename TFunc> void each(TFunc func) const
+		{
+			const std::vector<Archetype*> &archetypes = m_query->getArchetypes();
+			for(std::size_t i = 0; i < archetypes.size(); i++)
+			{
+				Archetype &archetype = *archetypes[i];
+				for(std::size_t chunk = 0; chunk < archetype.getChunkCount(); chunk++)
+				{
+					eachInChunk(func,
+						archetype.getChunkEntities(chunk),
+						archetype.getChunkEntityCount(chunk),
+						archetype.template getColumn<TTypes>(chunk)...);
+				}
+			}
+		};
+
+		std::size_t size() const
+		{
+			return m_query->getEntityCount();
+		};
+		bool empty() const
+		{
+			return begin() == end();
+		};
+
+	private:
+
+		const EntityQuery *m_query;
+
+		template<typename TFunc> static void eachInChunk(
+			TFunc &func,
+			Entity *const *entities,
+			std::size_t count,
+			TTypes *...columns)
+		{
+			for(std::size_t i = 0; i < count; i++)
+				func(*entities[i], columns[i]...);
+		};
+	};
+};
+
+#endif
@@ -1,7 +0,0 @@
-#include <Saurobyte/IdentifierTypes.hpp>
-
-namespace Saurobyte
-{
-	// Start at 1 to allow 0 to be an invalid index
-	TypeID TypeIdGrabber::currentTypeId = 1;
-};
@@ -1,29 +1,153 @@
 #ifndef JL_IDENTIFIERTYPES_HPP
 #define JL_IDENTIFIERTYPES_HPP
 
+#include <cstddef>
+#include <string>
+#include <bitset>
+
+// Maximum amount of systems in a SystemPool at once, see SystemSignature
+#ifndef SAUROBYTE_MAX_SYSTEMS
+	#define SAUROBYTE_MAX_SYSTEMS 64
+#endif
+
 namespace Saurobyte
 {
 
-	// Used when storying Entity ID's
+	// Used when storying Entity ID's, the ID is also the index of the entity
+	// slot in the EntityPool and is reused once the entity has been killed.
 	typedef unsigned int EntityID;
 
+	/*
+	EntityHandle
+
+	Reference to an entity that can be checked for validity. Every entity slot
+	has a generation which is increased when its entity is killed, so handles
+	to killed entities never match entities that reuse the slot.
+	*/
+	struct EntityHandle
+	{
+		EntityID id;
+
+		// Generation 0 is never used by an entity, making the default handle invalid
+		unsigned int generation;
+
+		EntityHandle() : id(0), generation(0) {};
+		EntityHandle(EntityID entityID, unsigned int entityGeneration) : id(entityID), generation(entityGeneration) {};
+
+		bool operator==(const EntityHandle &rhs) const { return id == rhs.id && generation == rhs.generation; };
+		bool operator!=(const EntityHandle &rhs) const { return !(*this == rhs); };
+	};
+
 	// Used when storing type ID's
 	typedef unsigned int TypeID;
 
+	// One bit per system of a SystemPool, see BaseSystem::getSystemIndex
+	typedef std::bitset<SAUROBYTE_MAX_SYSTEMS> SystemSignature;
+
+	namespace detail
+	{
+		// 32 bit FNV-1a hash of the first 'length' characters of 'str'
+		constexpr TypeID hashString(const char *str, std::size_t length, TypeID hash = 2166136261u)
+		{
+			return length == 0 ? hash :
+				hashString(str + 1, length - 1, (hash ^ static_cast<unsigned char>(*str)) * 16777619u);
+		};
+		constexpr std::size_t stringLength(const char *str)
+		{
+			return *str == '\0' ? 0 : 1 + stringLength(str + 1);
+		};
+		constexpr bool startsWith(const char *str, const char *prefix)
+		{
+			return *prefix == '\0' || (*str == *prefix && startsWith(str + 1, prefix + 1));
+		};
+		constexpr std::size_t findString(const char *str, const char *pattern, std::size_t offset = 0)
+		{
+			return str[offset] == '\0' || startsWith(str + offset, pattern) ? offset : findString(str, pattern, offset + 1);
+		};
+		constexpr bool isIdentifierChar(char c)
+		{
+			return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+		};
+		// Length of a "class ", "struct " or "enum " keyword at the start of 'str', 0 if there is none
+		constexpr std::size_t keywordLength(const char *str, std::size_t length)
+		{
+			return length >= 6 && startsWith(str, "class ") ? 6 :
+				length >= 7 && startsWith(str, "struct ") ? 7 :
+				length >= 5 && startsWith(str, "enum ") ? 5 : 0;
+		};
+		// Hash of a type name as hashString, skipping whitespace and the class-key keywords MSVC spells out,
+		// so "class Foo<struct Bar>" and "Foo<Bar>" hash the same
+		constexpr TypeID hashTypeName(const char *str, std::size_t length, char previous = ' ', TypeID hash = 2166136261u)
+		{
+			return length == 0 ? hash :
+				!isIdentifierChar(previous) && keywordLength(str, length) != 0 ?
+					hashTypeName(str + keywordLength(str, length), length - keywordLength(str, length), previous, hash) :
+				*str == ' ' ? hashTypeName(str + 1, length - 1, previous, hash) :
+				hashTypeName(str + 1, length - 1, *str, (hash ^ static_cast<unsigned char>(*str)) * 16777619u);
+		};
+
+		// The signature of this function contains the name of TType as spelled by the compiler
+		template<typename TType> constexpr const char* getTypeSignature()
+		{
+#if defined(_MSC_VER)
+			return __FUNCSIG__;
+#else
+			return __PRETTY_FUNCTION__;
+#endif
+		};
+
+		/*
+		TypeIdentifier
+
+		Compile time name and ID of a type. The name is cut out of the signature of
+		getTypeSignature, i.e "... getTypeSignature() [with TType = Foo]" on GCC.
+		*/
+		template<typename TType> struct TypeIdentifier
+		{
+#if defined(_MSC_VER)
+			// "... getTypeSignature<Foo>(void)"
+			static constexpr std::size_t nameBegin = findString(getTypeSignature<TType>(), "getTypeSignature<") + 17;
+			static constexpr std::size_t nameEnd = stringLength(getTypeSignature<TType>()) - 7;
+#else
+			// "... getTypeSignature() [with TType = Foo]" or "... getTypeSignature() [TType = Foo]"
+			static constexpr std::size_t nameBegin = findString(getTypeSignature<TType>(), "TType = ") + 8;
+			static constexpr std::size_t nameEnd = stringLength(getTypeSignature<TType>()) - 1;
+#endif
+			static constexpr std::size_t nameLength = nameEnd - nameBegin;
+
+			// 0 is reserved as an invalid ID
+			static constexpr TypeID hash = hashTypeName(getTypeSignature<TType>() + nameBegin, nameLength);
+			static constexpr TypeID id = hash == 0 ? 1 : hash;
+		};
+	};
+
 	/*
 	TypeIdGrabber
 
-	Used to retrieve unique ID's per type
+	Used to retrieve unique ID's per type. The ID is a hash of the type name, so it
+	is a compile time constant and stays the same between runs and builds, making
+	it usable in serialized data. Whitespace and class-keys are left out of the
+	hash so GCC, Clang and MSVC agree on the ID of a type, though names the
+	compilers spell differently (anonymous namespaces, builtin aliases such as
+	__int64) still hash differently. Dense indices of component types are handed out
+	by ComponentType, which also reports colliding hashes.
 	*/
 	struct TypeIdGrabber
 	{
-		static TypeID currentTypeId;
-		template<typename TIdType> static TypeID getUniqueTypeID()
+		template<typename TIdType> static constexpr TypeID getUniqueTypeID()
+		{
+			return detail::TypeIdentifier<TIdType>::id;
+		};
+
+		/**
+		 * Retrieves the name of a type as spelled by the compiler, i.e "Saurobyte::TransformComponent"
+		 * @return The name of the type
+		 */
+		template<typename TIdType> static std::string getTypeName()
 		{
-			// This variable, since it's static in a template function, will
-			// have the same value for same values of TIdType
-			static const TypeID id = TypeIdGrabber::currentTypeId++;
-			return id;
+			return std::string(
+				detail::getTypeSignature<TIdType>() + detail::TypeIdentifier<TIdType>::nameBegin,
+				detail::TypeIdentifier<TIdType>::nameLength);
 		};
 	};
 
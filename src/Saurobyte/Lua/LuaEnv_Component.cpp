@@ -27,9 +27,54 @@ IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <Saurobyte/Lua/LuaEnv_Component.hpp>
 #include <Saurobyte/LuaEnvironment.hpp>
 #include <Saurobyte/Engine.hpp>
+#include <Saurobyte/ComponentType.hpp>
 
 namespace Saurobyte
 {		
+	namespace
+	{
+		// Pushes the value of a reflected field, returns the amount of values pushed
+		int pushField(LuaEnvironment &env, const void *data, FieldType type)
+		{
+			switch(type)
+			{
+				case FieldType::Bool: env.pushArgs(*static_cast<const bool*>(data)); return 1;
+				case FieldType::Int: env.pushArgs(*static_cast<const int*>(data)); return 1;
+				case FieldType::UnsignedInt: env.pushArgs(*static_cast<const unsigned int*>(data)); return 1;
+				case FieldType::Float: env.pushArgs(*static_cast<const float*>(data)); return 1;
+				case FieldType::Double: env.pushArgs(*static_cast<const double*>(data)); return 1;
+				case FieldType::Vector3f:
+					{
+						const Vector3f &vector = *static_cast<const Vector3f*>(data);
+						env.pushArgs(vector.x, vector.y, vector.z);
+						return 3;
+					}
+			}
+
+			return 0;
+		}
+
+		// Reads the value of a reflected field from the function arguments
+		void readField(LuaEnvironment &env, void *data, FieldType type)
+		{
+			switch(type)
+			{
+				case FieldType::Bool: *static_cast<bool*>(data) = env.readArg<bool>(); break;
+				case FieldType::Int: *static_cast<int*>(data) = env.readArg<int>(); break;
+				case FieldType::UnsignedInt: *static_cast<unsigned int*>(data) = env.readArg<unsigned int>(); break;
+				case FieldType::Float: *static_cast<float*>(data) = env.readArg<float>(); break;
+				case FieldType::Double: *static_cast<double*>(data) = env.readArg<double>(); break;
+				case FieldType::Vector3f:
+					{
+						Vector3f &vector = *static_cast<Vector3f*>(data);
+						vector.x = env.readArg<float>();
+						vector.y = env.readArg<float>();
+						vector.z = env.readArg<float>();
+					}
+					break;
+			}
+		}
+	};
 
 
 	// Getter for component values
@@ -41,6 +86,12 @@ namespace Saurobyte
 		// Second argument is value identifier
 		std::string valueName = env.readArg<std::string>();
 
+		// Reflected fields are read directly, others are up to the component
+		const ComponentType *type = ComponentType::get(comp->getTypeID());
+		const ComponentField *field = type->getField(valueName);
+		if(field != nullptr)
+			return pushField(env, static_cast<unsigned char*>(type->fromBase(comp)) + field->offset, field->type);
+
 		return comp->onLuaGet(valueName, env);
 	}
 
@@ -59,7 +110,17 @@ namespace Saurobyte
 		//lua_remove(state, 1); // Pop two front elements
 		//lua_remove(state, 1);
 
-		comp->onLuaSet(valueName, env);
+		const ComponentType *type = ComponentType::get(comp->getTypeID());
+		const ComponentField *field = type->getField(valueName);
+		if(field != nullptr)
+		{
+			void *data = type->fromBase(comp);
+			readField(env, static_cast<unsigned char*>(data) + field->offset, field->type);
+			type->fieldsWritten(data);
+		}
+		else
+			comp->onLuaSet(valueName, env);
+
 		return 0;
 	}
 
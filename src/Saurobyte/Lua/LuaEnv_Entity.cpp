@@ -37,7 +37,9 @@ namespace Saurobyte
 	int LuaEnv_Entity::GetComponent(LuaEnvironment &env)
 	{
 		// First arg is self
-		Entity *entity = env.readArg<Entity*>("Saurobyte_Entity");
+		Entity *entity = readEntity(env);
+		if(entity == nullptr)
+			return 0;
 
 
 		// Second argument is comp name
@@ -55,7 +57,9 @@ namespace Saurobyte
 	int LuaEnv_Entity::GetComponentCount(LuaEnvironment &env)
 	{
 		// First arg is self
-		Entity *entity = env.readArg<Entity*>("Saurobyte_Entity");
+		Entity *entity = readEntity(env);
+		if(entity == nullptr)
+			return 0;
 
 		env.pushArgs(entity->getComponentCount());
 		return 1;
@@ -93,7 +97,9 @@ namespace Saurobyte
 	int LuaEnv_Entity::RemoveComponent(LuaEnvironment &env)
 	{
 		// First argument is self
-		Entity *entity = env.readArg<Entity*>("Saurobyte_Entity");
+		Entity *entity = readEntity(env);
+		if(entity == nullptr)
+			return 0;
 
 		// Second argument is component name
 		std::string valueName = env.readArg<std::string>();
@@ -112,7 +118,9 @@ namespace Saurobyte
 	int LuaEnv_Entity::HasComponent(LuaEnvironment &env)
 	{
 		// First argument is self
-		Entity *entity = env.readArg<Entity*>("Saurobyte_Entity");
+		Entity *entity = readEntity(env);
+		if(entity == nullptr)
+			return 0;
 
 		// Second argument is component name
 		std::string valueName = env.readArg<std::string>();
@@ -128,7 +136,9 @@ namespace Saurobyte
 	int LuaEnv_Entity::EnableEntity(LuaEnvironment &env)
 	{
 		// First argument is self
-		Entity *entity = env.readArg<Entity*>("Saurobyte_Entity");
+		Entity *entity = readEntity(env);
+		if(entity == nullptr)
+			return 0;
 
 		entity->setActive(true);
 
@@ -137,7 +147,9 @@ namespace Saurobyte
 	int LuaEnv_Entity::DisableEntity(LuaEnvironment &env)
 	{
 		// First argument is self
-		Entity *entity = env.readArg<Entity*>("Saurobyte_Entity");
+		Entity *entity = readEntity(env);
+		if(entity == nullptr)
+			return 0;
 
 		entity->setActive(false);
 
@@ -146,7 +158,9 @@ namespace Saurobyte
 	int LuaEnv_Entity::KillEntity(LuaEnvironment &env)
 	{
 		// First argument is self
-		Entity *entity = env.readArg<Entity*>("Saurobyte_Entity");
+		Entity *entity = readEntity(env);
+		if(entity == nullptr)
+			return 0;
 
 		entity->kill();
 
@@ -155,26 +169,64 @@ namespace Saurobyte
 	int LuaEnv_Entity::GetID(LuaEnvironment &env)
 	{
 		// First arg is self
-		Entity *entity = env.readArg<Entity*>("Saurobyte_Entity");
+		Entity *entity = readEntity(env);
+		if(entity == nullptr)
+			return 0;
 
 		env.pushArgs(entity->getID());
 		return 1;
 	}
+	int LuaEnv_Entity::SetParent(LuaEnvironment &env)
+	{
+		// First arg is self
+		Entity *entity = readEntity(env);
+		if(entity == nullptr)
+			return 0;
+
+		// Second arg is the parent, nil to detach
+		Entity *parent = nullptr;
+		if(env.isObject())
+		{
+			parent = readEntity(env);
+			if(parent == nullptr)
+				return 0;
+		}
+
+		entity->setParent(parent);
+		return 0;
+	}
+	int LuaEnv_Entity::GetParent(LuaEnvironment &env)
+	{
+		// First arg is self
+		Entity *entity = readEntity(env);
+		if(entity == nullptr)
+			return 0;
+
+		Entity *parent = entity->getParent();
+		if(parent == nullptr)
+			env.pushNil();
+		else
+			pushEntity(env, *parent);
+
+		return 1;
+	}
 	int LuaEnv_Entity::SubscribeEvent(LuaEnvironment &env)
 	{
 		// Lua system is upvalue
 		//LuaSystem* sys = static_cast<LuaSystem*>(lua_touserdata(state, lua_upvalueindex(1)));
 
 		// First arg is self
-		Entity *entity = env.readArg<Entity*>("Saurobyte_Entity");
+		Entity *entity = readEntity(env);
+		if(entity == nullptr)
+			return 0;
 
-		// Second arg is event name
-		std::string eventName = env.readArg<std::string>();
+		// Second arg is event name, turned into an ID once for all of its uses
+		MessageID eventID = env.readArg<std::string>();
 
 		if(env.readGlobal("SAUROBYTE_LUA_SYSTEM"))
 		{
 			LuaSystem *sys = env.readStack<LuaSystem*>("Saurobyte_LuaSystem");
-			sys->subscribeEntity(*entity, eventName);
+			sys->subscribeEntity(*entity, eventID);
 		}
 
 		//LuaComponent *comp = entity->getComponent<LuaComponent>();
@@ -189,15 +241,17 @@ namespace Saurobyte
 		//LuaSystem* sys = static_cast<LuaSystem*>(lua_touserdata(state, lua_upvalueindex(1)));
 
 		// First arg is self
-		Entity *entity = env.readArg<Entity*>("Saurobyte_Entity");
+		Entity *entity = readEntity(env);
+		if(entity == nullptr)
+			return 0;
 
-		// Second arg is event name
-		std::string eventName = env.readArg<std::string>();
+		// Second arg is event name, turned into an ID once for all of its uses
+		MessageID eventID = env.readArg<std::string>();
 
 		if(env.readGlobal("SAUROBYTE_LUA_SYSTEM"))
 		{
 			LuaSystem *sys = env.readStack<LuaSystem*>("Saurobyte_LuaSystem");
-			sys->unsubscribeEntity(*entity, eventName);
+			sys->unsubscribeEntity(*entity, eventID);
 		}
 
 		//LuaComponent *comp = entity->getComponent<LuaComponent>();
@@ -208,6 +262,24 @@ namespace Saurobyte
 	}
 
 
+	void LuaEnv_Entity::pushEntity(LuaEnvironment &env, Entity &entity)
+	{
+		env.pushObject<EntityReference>({&entity, entity.getHandle()}, "Saurobyte_Entity");
+	}
+	Entity* LuaEnv_Entity::readEntity(LuaEnvironment &env)
+	{
+		EntityReference reference = env.readArg<EntityReference>("Saurobyte_Entity");
+
+		// The entity slot may have been reused by another entity
+		if(reference.entity->getHandle() != reference.handle)
+		{
+			SAUROBYTE_WARNING_LOG("Lua accessed an entity that has been killed");
+			return nullptr;
+		}
+
+		return reference.entity;
+	}
+
 	void LuaEnv_Entity::exposeToLua(Engine *engine)
 	{
 		/*const luaL_Reg entityFuncs[] = 
@@ -235,7 +307,9 @@ namespace Saurobyte
 			{ "Enable", EnableEntity },
 			{ "Disable", DisableEntity },
 			{ "Kill", KillEntity },
-			{ "GetID", GetID }
+			{ "GetID", GetID },
+			{ "SetParent", SetParent },
+			{ "GetParent", GetParent }
 		});
 
 		// Event subscribing requires LuaSystem so we make them into C closures
@@ -27,16 +27,26 @@ IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #ifndef SAUROBYTE_LUAENV_ENTITY_HPP
 #define SAUROBYTE_LUAENV_ENTITY_HPP
 
+#include <Saurobyte/IdentifierTypes.hpp>
 
 namespace Saurobyte
 {
 	class Engine;
+	class Entity;
 	class LuaEnvironment;
 	class LuaEnv_Entity
 	{
 
 	private:
 
+		// Entities are passed to Lua along with their handle, entity memory is
+		// never freed while the engine runs so the handle can always be checked.
+		struct EntityReference
+		{
+			Entity *entity;
+			EntityHandle handle;
+		};
+
 		// Add component to entity
 		//static int AddComponent = [] (LuaEnvironment &env);
 
@@ -67,6 +77,12 @@ namespace Saurobyte
 		// Get ID of entity
 		static int GetID(LuaEnvironment &env);
 
+		// Attach entity to a parent, or detach it when the parent is nil
+		static int SetParent(LuaEnvironment &env);
+
+		// Get parent of entity
+		static int GetParent(LuaEnvironment &env);
+
 
 		// Subscribe entity to an event
 		static int SubscribeEvent(LuaEnvironment &env);
@@ -77,6 +93,11 @@ namespace Saurobyte
 	public:
 
 		static void exposeToLua(Engine *engine);
+
+		// Pushes an entity onto the Lua stack as a Saurobyte_Entity object
+		static void pushEntity(LuaEnvironment &env, Entity &entity);
+		// Reads a Saurobyte_Entity argument, returns nullptr if the entity has been killed since it was pushed
+		static Entity* readEntity(LuaEnvironment &env);
 	};
 };
 
@@ -24,6 +24,7 @@ IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
 #include <Saurobyte/Lua/LuaEnv_Scene.hpp>
+#include <Saurobyte/Lua/LuaEnv_Entity.hpp>
 #include <Saurobyte/LuaEnvironment.hpp>
 #include <Saurobyte/Engine.hpp>
 
@@ -42,7 +43,7 @@ namespace Saurobyte
 		for(auto itr = scene->getEntities().begin(); itr != scene->getEntities().end(); itr++)
 		{
 			//lua_pushnumber(state, index++);
-			env.pushObject<Entity*>(itr->second, "Saurobyte_Entity");
+			LuaEnv_Entity::pushEntity(env, *itr->second);
 			env.tableWrite(index++);
 			//lua_settable(state, tableIndex);
 		}
@@ -64,7 +65,9 @@ namespace Saurobyte
 		Scene* scene = env.readArg<Scene*>("Saurobyte_Scene");
 
 		// Second arg is the entity to detach
-		Entity *entity = env.readArg<Entity*>("Saurobyte_Entity");
+		Entity *entity = LuaEnv_Entity::readEntity(env);
+		if(entity == nullptr)
+			return 0;
 
 		scene->detach(*entity);
 
@@ -76,7 +79,9 @@ namespace Saurobyte
 		Scene* scene = env.readArg<Scene*>("Saurobyte_Scene");
 
 		// Second arg is the entity to attach
-		Entity *entity = env.readArg<Entity*>("Saurobyte_Entity");
+		Entity *entity = LuaEnv_Entity::readEntity(env);
+		if(entity == nullptr)
+			return 0;
 
 		scene->attach(*entity);
 
@@ -88,7 +93,9 @@ namespace Saurobyte
 		Scene* scene = env.readArg<Scene*>("Saurobyte_Scene");
 
 		// Second arg is the entity to query
-		Entity *entity = env.readArg<Entity*>("Saurobyte_Entity");
+		Entity *entity = LuaEnv_Entity::readEntity(env);
+		if(entity == nullptr)
+			return 0;
 
 		env.pushArgs(scene->contains(*entity));
 
@@ -0,0 +1,54 @@
+/*
+
+	The MIT License (MIT)
+
+	Copyright (c) 2014 by Jakob Larsson
+
+	Permission is hereby granted, free of charge, to any person obtaining 
+	a copy of this software and associated documentation files (the "Software"), 
+	to deal in the Software without restriction, including without limitation the 
+	rights to use, copy, modify, merge, publish, distribute, sublicense, and/or 
+	sell copies of the Software, and to permit persons to whom the Software is 
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in 
+	all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+	IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+#include <Saurobyte/Message.hpp>
+#include <unordered_set>
+#include <mutex>
+
+namespace Saurobyte
+{
+	namespace
+	{
+		// Names of messages created at runtime, kept for the rest of the program
+		std::unordered_set<std::string>& getInternedNames()
+		{
+			static std::unordered_set<std::string> names;
+			return names;
+		}
+		std::mutex& getInternMutex()
+		{
+			static std::mutex mutex;
+			return mutex;
+		}
+	};
+
+	MessageID::MessageID(const std::string &name)
+		:
+		m_id(detail::hashString(name.c_str(), name.size()))
+	{
+		std::lock_guard<std::mutex> lock(getInternMutex());
+		m_name = getInternedNames().insert(name).first->c_str();
+	}
+};
@@ -28,10 +28,61 @@
 #define SAUROBYTE_MESSAGE_HPP
 
 #include <string>
+#include <functional>
+#include <utility>
+#include <algorithm>
 #include <Saurobyte/IdentifierTypes.hpp>
 
 namespace Saurobyte
 {
+	/*
+		MessageID
+
+		Identifies messages by a hash of their name, so sending, subscribing and
+		dispatching messages compares integers rather than strings. The hash of a
+		string literal is computed by the compiler, and names built at runtime
+		(i.e from Lua) are interned, taking a lock:
+
+			static constexpr MessageID KeyDown = "KeyDown";
+
+			subscribe(KeyDown);
+			sendMessage("KeyDown");
+			sendMessage(std::string("Key") + "Down");
+
+		Constant character arrays are taken for literals and must outlive the ID,
+		writable buffers are interned like runtime names. Names built at runtime
+		and sent repeatedly are best turned into an ID once and kept around.
+
+		Colliding names are reported when subscribed to, see MessageCentral::subscribe.
+	*/
+	class MessageID
+	{
+	public:
+
+		template<std::size_t TLength> constexpr MessageID(const char (&name)[TLength])
+			:
+			m_id(detail::hashString(name, detail::stringLength(name))),
+			m_name(name)
+		{};
+		template<std::size_t TLength> MessageID(char (&name)[TLength])
+			:
+			MessageID(std::string(name, std::find(name, name + TLength, '\0')))
+		{};
+		MessageID(const std::string &name);
+
+		constexpr TypeID getID() const { return m_id; };
+		// Returns the name of the message, which lives for the rest of the program
+		constexpr const char* getName() const { return m_name; };
+
+		constexpr bool operator==(const MessageID &rhs) const { return m_id == rhs.m_id; };
+		constexpr bool operator!=(const MessageID &rhs) const { return m_id != rhs.m_id; };
+
+	private:
+
+		TypeID m_id;
+		const char *m_name;
+	};
+
 	/*
 		Message
 		
@@ -41,8 +92,8 @@ namespace Saurobyte
 	template<typename TType> class MessageData;
 	struct Message
 	{
-		// String identifying the type of the message
-		const std::string name;
+		// Identifies the type of the message
+		const MessageID id;
 
 		// Optional entity argument is part of all messages
 		Entity *entity;
@@ -50,26 +101,26 @@ namespace Saurobyte
 		// Type of the message data, if any
 		const TypeID dataType;
 
-		Message(const std::string &messageName, Entity *entityPtr = nullptr, TypeID typeID = TypeIdGrabber::getUniqueTypeID<Message>())
+		Message(const MessageID &messageID, Entity *entityPtr = nullptr, TypeID typeID = TypeIdGrabber::getUniqueTypeID<Message>())
 			:
-			name(messageName),
+			id(messageID),
 			entity(entityPtr),
 			dataType(typeID)
 		{}
 
 		/**
-		 * Converts this message to a MessageData class and returns a copy of its data
+		 * Converts this message to a MessageData class and returns a reference to its data
 		 * @return The custom data of this message, if any (if not, this function may yield undefined behaviour)
 		 */
-		template<typename TType> TType read()
+		template<typename TType> const TType& read() const
 		{
-			return static_cast<MessageData<TType>*>(this)->data;
+			return static_cast<const MessageData<TType>*>(this)->data;
 		};
 		/**
 		 * Checks if this message contains data of the specified type
 		 * @return True if the message cotanins data of the type, false otherwise
 		 */
-		template<typename TType> bool isType()
+		template<typename TType> bool isType() const
 		{
 			return dataType == TypeIdGrabber::getUniqueTypeID<TType>();
 		};
@@ -84,12 +135,23 @@ namespace Saurobyte
 	{
 		TDataType data;
 
-		MessageData(const std::string &messageName, TDataType newData, Entity *entityPtr = nullptr)
+		MessageData(const MessageID &messageID, TDataType newData, Entity *entityPtr = nullptr)
 			:
-			Message(messageName, entityPtr, TypeIdGrabber::getUniqueTypeID<TDataType>()),
-			data(newData)
+			Message(messageID, entityPtr, TypeIdGrabber::getUniqueTypeID<TDataType>()),
+			data(std::move(newData))
 		{}
 	};
 };
 
-#endif
\ No newline at end of file
+namespace std
+{
+	template<> struct hash<Saurobyte::MessageID>
+	{
+		std::size_t operator()(const Saurobyte::MessageID &id) const
+		{
+			return id.getID();
+		};
+	};
+};
+
+#endif
@@ -1,10 +1,18 @@
 #include <Saurobyte/MessageCentral.hpp>
 #include <Saurobyte/MessageHandler.hpp>
 #include <Saurobyte/Message.hpp>
+#include <Saurobyte/Entity.hpp>
+#include <Saurobyte/Logger.hpp>
+#include <cstring>
 
 namespace Saurobyte
 {
 		MessageCentral::MessageCentral()
+			:
+			m_deliveryDepth(0),
+			m_hasRemovedCallbacks(false),
+			m_writeQueue(0),
+			m_postedMessages(SAUROBYTE_POSTED_MESSAGE_CAPACITY)
 		{
 
 		}
@@ -13,76 +21,238 @@ namespace Saurobyte
 			// Nullify center pointers of all handlers, so they don't get null exceptions when center is destroyed
 			for(auto itr = m_subscriptionCentral.begin(); itr != m_subscriptionCentral.end(); itr++)
 			{
-				std::vector<MessageHandler*>& listeners = itr->second;
-				for(std::size_t i = 0; i < listeners.size(); i++)
+				Subscribers &subscribers = itr->second;
+				for(std::size_t i = 0; i < subscribers.handlers.size(); i++)
 				{
-					listeners[i]->m_subscriptions.clear();
-					listeners[i]->m_center = nullptr;
+					subscribers.handlers[i]->m_subscriptions.clear();
+					subscribers.handlers[i]->m_center = nullptr;
+				}
+				for(std::size_t i = 0; i < subscribers.callbacks.size(); i++)
+				{
+					MessageHandler *handler = subscribers.callbacks[i]->handler;
+					if(handler != nullptr)
+					{
+						handler->m_subscriptions.clear();
+						handler->m_center = nullptr;
+					}
 				}
 			}
 			m_subscriptionCentral.clear();
 		}
 
-		void MessageCentral::subscribe(const std::string &messageName, MessageHandler *handler)
+		void MessageCentral::subscribe(const MessageID &messageID, MessageHandler *handler)
 		{
-			if(subscribedTo(messageName, handler))
-				return;
+			Subscribers &subscribers = getSubscribers(messageID);
+			for(std::size_t i = 0; i < subscribers.handlers.size(); i++)
+			{
+				if(subscribers.handlers[i] == handler)
+					return;
+			}
 
-			handler->m_subscriptions.insert(messageName); // Store local subscription info in the handler
-			m_subscriptionCentral[messageName].push_back(handler);
+			handler->m_subscriptions.insert(messageID); // Store local subscription info in the handler
+			subscribers.handlers.push_back(handler);
 		}
-		void MessageCentral::unsubscribe(const std::string &messageName, MessageHandler *handler)
+		void MessageCentral::unsubscribe(const MessageID &messageID, MessageHandler *handler)
 		{
-			std::vector<MessageHandler*>& listeners = m_subscriptionCentral[messageName];
-			if(subscribedTo(messageName, handler))
+			if(subscribedTo(messageID, handler))
 			{
 				// Remove local subscription info
-				handler->m_subscriptions.erase(messageName);
-				for(std::size_t i = 0; i < listeners.size(); i++)
-				{
-					if(listeners[i] == handler)
-					{
-						listeners.erase(listeners.begin() + i);
-						break;
-					}
-				}
+				handler->m_subscriptions.erase(messageID);
+				removeSubscriber(m_subscriptionCentral[messageID], handler);
 			}
 		}
 		void MessageCentral::unsubscribeAll(MessageHandler *handler)
 		{
 			for(auto itr = handler->m_subscriptions.begin(); itr != handler->m_subscriptions.end(); itr++)
+				removeSubscriber(m_subscriptionCentral[*itr], handler);
+
+			// Remove local subscription info
+			handler->m_subscriptions.clear();
+		}
+		void MessageCentral::subscribeCallback(
+			const MessageID &messageID,
+			MessageHandler *handler,
+			TypeID dataType,
+			std::function<void(const Message&)> callback)
+		{
+			// The data type is checked here once, so delivering to callbacks only compares the type of each message
+			Subscribers &subscribers = getSubscribers(messageID);
+			if(subscribers.callbacks.empty())
+				subscribers.dataType = dataType;
+			else if(subscribers.dataType != dataType)
+				SAUROBYTE_FATAL_LOG("Message '", messageID.getName(), "' is subscribed to with callbacks of different data types");
+
+			std::unique_ptr<MessageCallback> subscription(new MessageCallback());
+			subscription->handler = handler;
+			subscription->callback = std::move(callback);
+
+			handler->m_subscriptions.insert(messageID);
+			subscribers.callbacks.push_back(std::move(subscription));
+		}
+
+		MessageCentral::Subscribers& MessageCentral::getSubscribers(const MessageID &messageID)
+		{
+			// Entries are kept once created, so every name ever subscribed to is checked
+			auto iter = m_subscriptionCentral.find(messageID);
+			if(iter == m_subscriptionCentral.end())
+				return m_subscriptionCentral[messageID];
+
+			if(std::strcmp(iter->first.getName(), messageID.getName()) != 0)
+				SAUROBYTE_FATAL_LOG("Message names '", iter->first.getName(), "' and '", messageID.getName(), "' have the same hash, rename one of them");
+
+			return iter->second;
+		}
+		void MessageCentral::removeSubscriber(Subscribers &subscribers, MessageHandler *handler)
+		{
+			for(std::size_t i = 0; i < subscribers.handlers.size(); i++)
 			{
-				std::vector<MessageHandler*>& listeners = m_subscriptionCentral[*itr];
-				for(std::size_t i = 0; i < listeners.size(); i++)
+				if(subscribers.handlers[i] == handler)
 				{
-					if(listeners[i] == handler)
-					{
-						listeners.erase(listeners.begin() + i);
-						break;
-					}
+					subscribers.handlers.erase(subscribers.handlers.begin() + i);
+					break;
 				}
 			}
 
-			// Remove local subscription info
-			handler->m_subscriptions.clear();
+			for(std::size_t i = 0; i < subscribers.callbacks.size();)
+			{
+				if(subscribers.callbacks[i]->handler != handler)
+					i++;
+				else if(m_deliveryDepth > 0)
+				{
+					// The callback may be the one running, so it's only detached until the delivery is done
+					subscribers.callbacks[i++]->handler = nullptr;
+					m_hasRemovedCallbacks = true;
+				}
+				else
+					subscribers.callbacks.erase(subscribers.callbacks.begin() + i);
+			}
 		}
 
 		void MessageCentral::sendMessage(const Message &message)
 		{
-			auto iter = m_subscriptionCentral.find(message.name);
-			if(iter != m_subscriptionCentral.end())
+			auto iter = m_subscriptionCentral.find(message.id);
+			deliver(message, iter == m_subscriptionCentral.end() ? nullptr : &iter->second);
+		}
+		void MessageCentral::sendMessage(const MessageID &messageID, Entity *entity)
+		{
+			sendMessage(Message(messageID, entity));
+		}
+		void MessageCentral::sendMessage(Message &message, const std::vector<Entity*> &entities)
+		{
+			auto iter = m_subscriptionCentral.find(message.id);
+			Subscribers *subscribers = iter == m_subscriptionCentral.end() ? nullptr : &iter->second;
+
+			for(std::size_t i = 0; i < entities.size(); i++)
 			{
-				for(std::size_t i = 0; i < iter->second.size(); i++)
-					iter->second[i]->onMessage(message);
+				message.entity = entities[i];
+				deliver(message, subscribers);
 			}
 		}
-		void MessageCentral::sendMessage(const std::string &messageName, Entity *entity)
+
+		void MessageCentral::queueMessage(const MessageID &messageID, Entity *entity)
+		{
+			m_queues[m_writeQueue].push<Message>(messageID, entity);
+		}
+		void MessageCentral::dispatchQueuedMessages()
 		{
-			sendMessage(Message(messageName, entity));
+			for(unsigned int round = 0; round < SAUROBYTE_MAX_MESSAGE_ROUNDS && m_queues[m_writeQueue].getSize() > 0; round++)
+			{
+				MessageQueue &queue = m_queues[m_writeQueue];
+				m_writeQueue = 1 - m_writeQueue;
+
+				queue.sortByID();
+				for(std::size_t i = 0; i < queue.getSize();)
+				{
+					// Look up the subscribers once per batch, entries are never erased so the pointer stays valid
+					MessageID id = queue.getMessage(i).id;
+					auto iter = m_subscriptionCentral.find(id);
+					Subscribers *subscribers = iter == m_subscriptionCentral.end() ? nullptr : &iter->second;
+
+					for(; i < queue.getSize() && queue.getMessage(i).id == id; i++)
+					{
+						// Messages about entities killed since they were queued are dropped
+						if(!queue.isStale(i))
+							deliver(queue.getMessage(i), subscribers);
+					}
+				}
+
+				queue.clear();
+			}
+		}
+		std::size_t MessageCentral::getQueuedMessageCount() const
+		{
+			return m_queues[m_writeQueue].getSize();
+		}
+		bool MessageCentral::postMessage(const MessageID &messageID, Entity *entity)
+		{
+			return m_postedMessages.push<Message>(messageID, entity);
+		}
+		void MessageCentral::dispatchPostedMessages()
+		{
+			// Messages posted meanwhile are left for the next frame, so busy producers can't stall the frame
+			for(std::size_t i = 0; i < m_postedMessages.getCapacity(); i++)
+			{
+				Message *message = m_postedMessages.front();
+				if(message == nullptr)
+					break;
+
+				sendMessage(*message);
+				m_postedMessages.pop();
+			}
+		}
+		void MessageCentral::deliver(const Message &message, Subscribers *subscribers)
+		{
+			// Messages concerning a sleeping entity wake it up
+			if(message.entity != nullptr && message.entity->isSleeping())
+				message.entity->wake();
+
+			if(subscribers == nullptr)
+				return;
+
+			m_deliveryDepth++;
+
+			for(std::size_t i = 0; i < subscribers->handlers.size(); i++)
+				subscribers->handlers[i]->onMessage(message);
+
+			if(!subscribers->callbacks.empty())
+			{
+				if(message.dataType != subscribers->dataType)
+					SAUROBYTE_WARNING_LOG("Message '", message.id.getName(), "' was sent with data of another type than its callbacks take");
+				else
+				{
+					// Callbacks are stored by pointer, so they stay in place when callbacks are subscribed meanwhile
+					for(std::size_t i = 0; i < subscribers->callbacks.size(); i++)
+					{
+						MessageCallback &subscription = *subscribers->callbacks[i];
+						if(subscription.handler != nullptr)
+							subscription.callback(message);
+					}
+				}
+			}
+
+			m_deliveryDepth--;
+
+			// Erase callbacks unsubscribed while delivering, once nothing is delivered anymore
+			if(m_deliveryDepth == 0 && m_hasRemovedCallbacks)
+			{
+				for(auto itr = m_subscriptionCentral.begin(); itr != m_subscriptionCentral.end(); itr++)
+				{
+					std::vector<std::unique_ptr<MessageCallback> > &callbacks = itr->second.callbacks;
+					for(std::size_t i = 0; i < callbacks.size();)
+					{
+						if(callbacks[i]->handler == nullptr)
+							callbacks.erase(callbacks.begin() + i);
+						else
+							i++;
+					}
+				}
+
+				m_hasRemovedCallbacks = false;
+			}
 		}
 
-		bool MessageCentral::subscribedTo(const std::string &messageName, const MessageHandler *handler) const
+		bool MessageCentral::subscribedTo(const MessageID &messageID, const MessageHandler *handler) const
 		{
-			return handler->m_subscriptions.find(messageName) != handler->m_subscriptions.end();
+			return handler->m_subscriptions.find(messageID) != handler->m_subscriptions.end();
 		}
-};
\ No newline at end of file
+};
@@ -29,9 +29,24 @@
 
 #include <Saurobyte/ApiDefines.hpp>
 #include <Saurobyte/Message.hpp>
+#include <Saurobyte/MessageQueue.hpp>
+#include <Saurobyte/ConcurrentMessageQueue.hpp>
 #include <unordered_set>
 #include <unordered_map>
 #include <vector>
+#include <memory>
+#include <functional>
+
+// Maximum amount of rounds of queued messages sent by a single dispatch, messages
+// queued by handlers in the last round are sent by the next dispatch.
+#ifndef SAUROBYTE_MAX_MESSAGE_ROUNDS
+	#define SAUROBYTE_MAX_MESSAGE_ROUNDS 4
+#endif
+
+// Maximum amount of messages posted from other threads that may wait for the next frame
+#ifndef SAUROBYTE_POSTED_MESSAGE_CAPACITY
+	#define SAUROBYTE_POSTED_MESSAGE_CAPACITY 1024
+#endif
 
 namespace Saurobyte
 {
@@ -44,32 +59,133 @@ namespace Saurobyte
 		MessageCentral();
 		~MessageCentral();
 		
-		// Subscribe the specified handler to messages of the specified name
-		void subscribe(const std::string &messageName, MessageHandler *handler);
+		// Subscribe the specified handler to messages of the specified name. Names with the
+		// same hash as a name subscribed to before are fatal, since their messages can't be told apart.
+		void subscribe(const MessageID &messageID, MessageHandler *handler);
+		/**
+		 * Subscribes a callback taking the data of the message, which is passed straight from the sent message
+		 * without copying it or going through MessageHandler::onMessage. All callbacks of a message must take the
+		 * same data type, messages sent with data of another type aren't passed to them.
+		 * @param messageID The name of the message
+		 * @param handler   The handler owning the callback, unsubscribing it also unsubscribes the callback
+		 * @param callback  The function to call with the data of every message
+		 */
+		template<typename TType> void subscribe(
+			const MessageID &messageID,
+			MessageHandler *handler,
+			std::function<void(const TType&)> callback)
+		{
+			subscribeCallback(messageID, handler, TypeIdGrabber::getUniqueTypeID<TType>(), [callback](const Message &message)
+			{
+				callback(static_cast<const MessageData<TType>&>(message).data);
+			});
+		};
 
 		// Unsubscribe the specified handler from messages of the specified name
-		void unsubscribe(const std::string &messageName, MessageHandler *handler);
+		void unsubscribe(const MessageID &messageID, MessageHandler *handler);
 		// Unsubscribe the specified handler from all messages it's currently subscribed to
 		// , used primarily for cleanup.
 		void unsubscribeAll(MessageHandler *handler);
 
 		// Broadcast message instantly, sending it to those who subscribes to messages of its type
 		void sendMessage(const Message &message);
-		void sendMessage(const std::string &messageName, Entity *entity = nullptr);
-		template<typename TType> void sendMessage(const std::string &messageName, TType data, Entity *entity = nullptr)
+		void sendMessage(const MessageID &messageID, Entity *entity = nullptr);
+		template<typename TType> void sendMessage(const MessageID &messageID, TType data, Entity *entity = nullptr)
+		{
+			sendMessage(MessageData<TType>(messageID, std::move(data), entity));
+		};
+		// Broadcast a message once for every entity, setting it as the entity of the message, subscribers are looked up once
+		void sendMessage(Message &message, const std::vector<Entity*> &entities);
+
+		/**
+		 * Queues a message rather than sending it right away, it's sent by the next dispatchQueuedMessages. The message
+		 * and its data are constructed in a per-frame arena, so queueing allocates nothing once the arena has grown.
+		 * @param messageID The name of the message
+		 * @param data      Data to be sent with the message
+		 * @param entity    Optional entity pointer to be sent with the message, the message is dropped if the entity is
+		 *                  killed before dispatch
+		 */
+		template<typename TType> void queueMessage(const MessageID &messageID, TType data, Entity *entity = nullptr)
+		{
+			m_queues[m_writeQueue].push<MessageData<TType> >(messageID, std::move(data), entity);
+		};
+		void queueMessage(const MessageID &messageID, Entity *entity = nullptr);
+
+		/**
+		 * Sends all queued messages in batches of the same message ID, in the order they were queued within a batch.
+		 * Batches are sent in order of their ID hashes, so messages with different IDs may arrive in another order
+		 * than they were queued in.
+		 * Messages queued by handlers meanwhile are sent in another round, up to SAUROBYTE_MAX_MESSAGE_ROUNDS rounds.
+		 * Called by World::frame at the start of every frame.
+		 */
+		void dispatchQueuedMessages();
+		std::size_t getQueuedMessageCount() const;
+
+		/**
+		 * Posts a message from any thread, it's sent on the thread ticking the world by the next
+		 * dispatchPostedMessages. Posting never locks, unless the message name is built at runtime
+		 * and has to be interned. The data must fit in ConcurrentMessageQueue::SlotSize.
+		 * @param  messageID The name of the message
+		 * @param  data      Data to be sent with the message
+		 * @param  entity    Optional entity pointer to be sent with the message
+		 * @return           False if SAUROBYTE_POSTED_MESSAGE_CAPACITY messages are already waiting, in which case the message is dropped
+		 */
+		template<typename TType> bool postMessage(const MessageID &messageID, TType data, Entity *entity = nullptr)
 		{
-			sendMessage(MessageData<TType>(messageName, data, entity));
+			return m_postedMessages.push<MessageData<TType> >(messageID, std::move(data), entity);
 		};
+		bool postMessage(const MessageID &messageID, Entity *entity = nullptr);
+
+		/**
+		 * Sends the messages posted from other threads, in the order they were posted.
+		 * Called by World::frame at the start of every frame.
+		 */
+		void dispatchPostedMessages();
 
 		// Checks whether or not the specified handler is subscribed to the specified message
-		bool subscribedTo(const std::string &messageName, const MessageHandler *handler) const;
+		bool subscribedTo(const MessageID &messageID, const MessageHandler *handler) const;
 
 	private:
 
-		typedef std::unordered_map<std::string, std::vector<MessageHandler*> > MessageSubscriptions;
+		struct MessageCallback
+		{
+			// Set to null when unsubscribed while delivering
+			MessageHandler *handler;
+			std::function<void(const Message&)> callback;
+		};
+		struct Subscribers
+		{
+			std::vector<MessageHandler*> handlers;
+
+			// Typed callbacks and the data type they all take
+			std::vector<std::unique_ptr<MessageCallback> > callbacks;
+			TypeID dataType;
+		};
+		typedef std::unordered_map<MessageID, Subscribers> MessageSubscriptions;
 
 		MessageSubscriptions m_subscriptionCentral;
 
+		// Callbacks can't be erased while a message is delivered, since one of them may be running
+		unsigned int m_deliveryDepth;
+		bool m_hasRemovedCallbacks;
+
+		// Queued messages, double buffered so messages queued while dispatching end up in the other queue
+		MessageQueue m_queues[2];
+		std::size_t m_writeQueue;
+
+		// Messages posted from other threads
+		ConcurrentMessageQueue m_postedMessages;
+
+		void subscribeCallback(
+			const MessageID &messageID,
+			MessageHandler *handler,
+			TypeID dataType,
+			std::function<void(const Message&)> callback);
+		Subscribers& getSubscribers(const MessageID &messageID);
+		void removeSubscriber(Subscribers &subscribers, MessageHandler *handler);
+
+		void deliver(const Message &message, Subscribers *subscribers);
+
 	};
 };
 
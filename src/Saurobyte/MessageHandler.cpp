@@ -41,15 +41,15 @@ namespace Saurobyte
 				m_center->unsubscribeAll(this);
 		}
 
-		void MessageHandler::subscribe(const std::string &messageName)
+		void MessageHandler::subscribe(const MessageID &messageID)
 		{
 			if(m_center != nullptr)
-				m_center->subscribe(messageName, this);
+				m_center->subscribe(messageID, this);
 		}
-		void MessageHandler::unsubscribe(const std::string &messageName)
+		void MessageHandler::unsubscribe(const MessageID &messageID)
 		{
 			if(m_center != nullptr)
-				m_center->unsubscribe(messageName, this);
+				m_center->unsubscribe(messageID, this);
 		}
 		
 		void MessageHandler::sendMessage(const Message &message)
@@ -57,15 +57,20 @@ namespace Saurobyte
 			if(m_center != nullptr)
 				m_center->sendMessage(message);
 		}
-		void MessageHandler::sendMessage(const std::string &messageName, Entity *entity)
+		void MessageHandler::sendMessage(const MessageID &messageID, Entity *entity)
 		{
-			sendMessage(Message(messageName, entity));
+			sendMessage(Message(messageID, entity));
+		}
+		void MessageHandler::queueMessage(const MessageID &messageID, Entity *entity)
+		{
+			if(m_center != nullptr)
+				m_center->queueMessage(messageID, entity);
 		}
 
-		bool MessageHandler::subscribedTo(const std::string &messageName) const
+		bool MessageHandler::subscribedTo(const MessageID &messageID) const
 		{
 
-			return m_center == nullptr ? false : m_center->subscribedTo(messageName, this);
+			return m_center == nullptr ? false : m_center->subscribedTo(messageID, this);
 		}
 
 };
\ No newline at end of file
@@ -29,12 +29,12 @@
 
 #include <Saurobyte/ApiDefines.hpp>
 #include <Saurobyte/Message.hpp>
+#include <Saurobyte/MessageCentral.hpp>
 #include <string>
 #include <unordered_set>
 
 namespace Saurobyte
 {
-	class MessageCentral;
 	class SAUROBYTE_API MessageHandler
 	{
 	public:
@@ -48,15 +48,26 @@ namespace Saurobyte
 	protected:
 		/**
 		 * Subscribe this handler to messages of the specified name
-		 * @param messageName The message name to subscribe to
+		 * @param messageID The message name to subscribe to
 		 */
-		void subscribe(const std::string &messageName);
+		void subscribe(const MessageID &messageID);
+		/**
+		 * Subscribe a callback to messages of the specified name, which is called with a reference to the data of
+		 * each message rather than through onMessage. Unsubscribing from the message also removes the callback.
+		 * @param messageID The message name to subscribe to
+		 * @param callback  Function called with the data of each message
+		 */
+		template<typename TType> void subscribe(const MessageID &messageID, std::function<void(const TType&)> callback)
+		{
+			if(m_center != nullptr)
+				m_center->subscribe<TType>(messageID, this, std::move(callback));
+		};
 
 		/**
 		 * Unsubscribe this handler from messages of the specified type, only has an effect if the handler is already subscribed
-		 * @param messageName The message name to subscribe to
+		 * @param messageID The message name to unsubscribe from
 		 */
-		void unsubscribe(const std::string &messageName);
+		void unsubscribe(const MessageID &messageID);
 
 		/**
 		 * Broadcasts a message through the central to all subscribers of the message
@@ -65,27 +76,45 @@ namespace Saurobyte
 		void sendMessage(const Message &message);
 		/**
 		 * Broadcasts a message through the central to all subscribers of the message
-		 * @param messageName The name/title of the message, used for identifying it
-		 * @param entity      Optional entity pointer to be sent with the message
+		 * @param messageID The name/title of the message, used for identifying it
+		 * @param entity    Optional entity pointer to be sent with the message
 		 */
-		void sendMessage(const std::string &messageName, Entity *entity = nullptr);
+		void sendMessage(const MessageID &messageID, Entity *entity = nullptr);
 		/**
 		 * Broadcasts a message through the central to all subscribers of the message
-		 * @param messageName The name/title of the message, used for identifying it
-		 * @param data        Data to be sent with the message
-		 * @param entity      Optional entity pointer to be sent with the message
+		 * @param messageID The name/title of the message, used for identifying it
+		 * @param data      Data to be sent with the message
+		 * @param entity    Optional entity pointer to be sent with the message
+		 */
+		template<typename TType> void sendMessage(const MessageID &messageID, TType data, Entity *entity = nullptr)
+		{
+			sendMessage(MessageData<TType>(messageID, std::move(data), entity));
+		};
+
+		/**
+		 * Queues a message in the central, it's sent to all subscribers at the start of the next frame
+		 * @param messageID The name/title of the message, used for identifying it
+		 * @param entity    Optional entity pointer to be sent with the message
+		 */
+		void queueMessage(const MessageID &messageID, Entity *entity = nullptr);
+		/**
+		 * Queues a message in the central, it's sent to all subscribers at the start of the next frame
+		 * @param messageID The name/title of the message, used for identifying it
+		 * @param data      Data to be sent with the message
+		 * @param entity    Optional entity pointer to be sent with the message
 		 */
-		template<typename TType> void sendMessage(const std::string &messageName, TType data, Entity *entity = nullptr)
+		template<typename TType> void queueMessage(const MessageID &messageID, TType data, Entity *entity = nullptr)
 		{
-			sendMessage(MessageData<TType>(messageName, data, entity));
+			if(m_center != nullptr)
+				m_center->queueMessage<TType>(messageID, std::move(data), entity);
 		};
 		
 		/**
 		 * Checks if this handler is subscribed to the specified message
-		 * @param  messageName The message identifier to check
-		 * @return             Whether or not this handler subscribes to the message
+		 * @param  messageID The message identifier to check
+		 * @return           Whether or not this handler subscribes to the message
 		 */
-		bool subscribedTo(const std::string &messageName) const;
+		bool subscribedTo(const MessageID &messageID) const;
 
 
 		MessageHandler(MessageCentral *center);
@@ -98,7 +127,7 @@ namespace Saurobyte
 		friend class MessageCentral;
 
 		// Keep a local register of subscriptions for easy lookup
-		std::unordered_set<std::string> m_subscriptions;
+		std::unordered_set<MessageID> m_subscriptions;
 
 		MessageCentral *m_center;
 
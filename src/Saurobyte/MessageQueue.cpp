@@ -0,0 +1,106 @@
+/*
+
+	The MIT License (MIT)
+
+	Copyright (c) 2014 by Jakob Larsson
+
+	Permission is hereby granted, free of charge, to any person obtaining 
+	a copy of this software and associated documentation files (the "Software"), 
+	to deal in the Software without restriction, including without limitation the 
+	rights to use, copy, modify, merge, publish, distribute, sublicense, and/or 
+	sell copies of the Software, and to permit persons to whom the Software is 
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in 
+	all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+	IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+#include <Saurobyte/MessageQueue.hpp>
+#include <Saurobyte/Entity.hpp>
+#include <algorithm>
+
+namespace Saurobyte
+{
+	const std::size_t MessageQueue::ChunkSize;
+
+	MessageQueue::MessageQueue()
+		:
+		m_chunk(0),
+		m_offset(0)
+	{
+
+	}
+	MessageQueue::~MessageQueue()
+	{
+		clear();
+	}
+
+	void* MessageQueue::allocate(std::size_t size, std::size_t alignment)
+	{
+		// Chunks are allocated with new[], which aligns them for any fundamental type
+		std::size_t offset = (m_offset + alignment - 1) / alignment * alignment;
+
+		// Move on to the next chunk that fits the message, allocating one if none do
+		while(m_chunk < m_chunks.size() && offset + size > m_chunks[m_chunk].second)
+		{
+			m_chunk++;
+			offset = 0;
+		}
+		if(m_chunk == m_chunks.size())
+		{
+			std::size_t chunkSize = std::max(ChunkSize, size);
+			m_chunks.push_back(std::make_pair(std::unique_ptr<unsigned char[]>(new unsigned char[chunkSize]), chunkSize));
+			offset = 0;
+		}
+
+		m_offset = offset + size;
+		return m_chunks[m_chunk].first.get() + offset;
+	}
+
+	void MessageQueue::enqueue(Message *message, void (*destroy)(Message *message))
+	{
+		QueuedMessage queued = { message, destroy, message->entity == nullptr ? EntityHandle() : message->entity->getHandle() };
+		m_messages.push_back(queued);
+	}
+
+	void MessageQueue::sortByID()
+	{
+		std::stable_sort(m_messages.begin(), m_messages.end(),
+			[] (const QueuedMessage &lhs, const QueuedMessage &rhs) { return lhs.message->id.getID() < rhs.message->id.getID(); });
+	}
+	void MessageQueue::clear()
+	{
+		for(std::size_t i = 0; i < m_messages.size(); i++)
+		{
+			if(m_messages[i].destroy != nullptr)
+				m_messages[i].destroy(m_messages[i].message);
+		}
+
+		m_messages.clear();
+		m_chunk = 0;
+		m_offset = 0;
+	}
+
+	bool MessageQueue::isStale(std::size_t index) const
+	{
+		const QueuedMessage &queued = m_messages[index];
+		return queued.message->entity != nullptr && queued.message->entity->getHandle() != queued.entity;
+	}
+
+	Message& MessageQueue::getMessage(std::size_t index)
+	{
+		return *m_messages[index].message;
+	}
+	std::size_t MessageQueue::getSize() const
+	{
+		return m_messages.size();
+	}
+};
@@ -0,0 +1,122 @@
+/*
+
+	The MIT License (MIT)
+
+	Copyright (c) 2014 by Jakob Larsson
+
+	Permission is hereby granted, free of charge, to any person obtaining 
+	a copy of this software and associated documentation files (the "Software"), 
+	to deal in the Software without restriction, including without limitation the 
+	rights to use, copy, modify, merge, publish, distribute, sublicense, and/or 
+	sell copies of the Software, and to permit persons to whom the Software is 
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in 
+	all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+	IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+#ifndef SAUROBYTE_MESSAGE_QUEUE_HPP
+#define SAUROBYTE_MESSAGE_QUEUE_HPP
+
+#include <Saurobyte/Message.hpp>
+#include <Saurobyte/NonCopyable.hpp>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <memory>
+#include <new>
+
+namespace Saurobyte
+{
+	/*
+		MessageQueue
+
+		Messages queued for later dispatch, see MessageCentral::queueMessage.
+		Messages and their data are constructed in an arena of fixed size
+		chunks, and all of them are released at once by clear, which keeps
+		the chunks around. Once the arena has grown to what a frame needs,
+		queueing messages allocates nothing.
+
+		The handle of the entity of every message is kept alongside it, so
+		messages whose entity was killed before dispatch can be dropped
+		(see isStale).
+
+	*/
+	class MessageQueue : public NonCopyable
+	{
+	public:
+
+		// Size in bytes of a single chunk of message memory
+		static const std::size_t ChunkSize = 16 * 1024;
+
+		MessageQueue();
+		~MessageQueue();
+
+		/**
+		 * Constructs a message at the end of the queue
+		 * @param args Arguments passed to the constructor of the message
+		 */
+		template<typename TMessage, typename... TArgs> void push(TArgs&&... args)
+		{
+			void *memory = allocate(sizeof(TMessage), alignof(TMessage));
+			TMessage *message = new (memory) TMessage(std::forward<TArgs>(args)...);
+
+			// Most payloads need no destruction, so clearing them is free
+			enqueue(message, std::is_trivially_destructible<TMessage>::value ? nullptr : &destroy<TMessage>);
+		};
+
+		/**
+		 * Sorts the messages by their ID, keeping the order of messages with the same ID. IDs are hashes, so
+		 * messages of different IDs end up in hash order rather than the order they were queued in.
+		 */
+		void sortByID();
+
+		/**
+		 * Checks if the entity of a message was killed (and its slot possibly reused) since the message was queued
+		 * @param  index Index of the message
+		 * @return       True if the message should be dropped, false otherwise
+		 */
+		bool isStale(std::size_t index) const;
+
+		// Destroys all messages and resets the arena
+		void clear();
+
+		Message& getMessage(std::size_t index);
+		std::size_t getSize() const;
+
+	private:
+
+		struct QueuedMessage
+		{
+			Message *message;
+			void (*destroy)(Message *message);
+
+			// Entities keep their memory when killed, only their handle tells whether it is still the same entity
+			EntityHandle entity;
+		};
+		std::vector<QueuedMessage> m_messages;
+
+		template<typename TMessage> static void destroy(Message *message)
+		{
+			static_cast<TMessage*>(message)->~TMessage();
+		};
+
+		// Arena chunks along with their sizes, oversized messages get a chunk of their own
+		std::vector<std::pair<std::unique_ptr<unsigned char[]>, std::size_t> > m_chunks;
+		std::size_t m_chunk;
+		std::size_t m_offset;
+
+		void* allocate(std::size_t size, std::size_t alignment);
+		void enqueue(Message *message, void (*destroy)(Message *message));
+	};
+};
+
+#endif
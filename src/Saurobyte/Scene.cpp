@@ -9,6 +9,12 @@ namespace Saurobyte
 	{
 
 	}
+	Scene::~Scene()
+	{
+		// Entities outlive their scene
+		for(auto itr = m_entities.begin(); itr != m_entities.end(); itr++)
+			itr->second->m_scene = nullptr;
+	}
 
 	void Scene::attach(Entity &entity)
 	{
@@ -22,18 +28,17 @@ namespace Saurobyte
 	}
 	void Scene::detach(Entity &entity)
 	{
-		auto itr = m_entities.find(entity.getID());
-		if(itr != m_entities.end())
+		if(entity.m_scene == this)
 		{
 			entity.detach();
 			entity.m_scene = nullptr;
-			m_entities.erase(itr);
+			m_entities.erase(entity.getID());
 		}
 	}
 
-	bool Scene::contains(Entity &entity)
+	bool Scene::contains(const Entity &entity) const
 	{
-		return m_entities.find(entity.getID()) != m_entities.end();
+		return entity.m_scene == this;
 	}
 
 	const std::unordered_map<EntityID, Entity*>& Scene::getEntities()
@@ -21,11 +21,12 @@ namespace Saurobyte
 	public:
 
 		Scene(const std::string &name);
+		~Scene();
 
 		void attach(Entity &entity);
 		void detach(Entity &entity);
 
-		bool contains(Entity &entity);
+		bool contains(const Entity &entity) const;
 
 		const std::unordered_map<EntityID, Entity*>& getEntities();
 		std::string getName() const;
@@ -1,14 +1,14 @@
 #include <Saurobyte/ScenePool.hpp>
-#include <Saurobyte/Engine.hpp>
+#include <Saurobyte/World.hpp>
 #include <Saurobyte/Message.hpp>
 #include <Saurobyte/Logger.hpp>
 
 namespace Saurobyte
 {
-	ScenePool::ScenePool(Engine *engine)
+	ScenePool::ScenePool(World *world)
 		:
 		m_activeScene(nullptr),
-		m_engine(engine)
+		m_world(world)
 	{
 	}
 	ScenePool::~ScenePool()
@@ -47,8 +47,9 @@ namespace Saurobyte
 
 	void ScenePool::detachFromAllScenes(Entity &entity)
 	{
-		for(auto itr = m_scenePool.begin(); itr != m_scenePool.end(); itr++)
-			itr->second->detach(entity);
+		// An entity is in at most one scene, which it keeps track of
+		if(entity.getScene() != nullptr)
+			entity.getScene()->detach(entity);
 	}
 	void ScenePool::frameCleanup()
 	{
@@ -61,7 +62,7 @@ namespace Saurobyte
 			{
 				// Empty systems if we deleted the active scene
 				if(scene == m_activeScene)
-					m_engine->getSystemPool().emptySystems();
+					m_world->getSystemPool().emptySystems();
 
 				SAUROBYTE_DEBUG_LOG("Deleting scene '", scene->getName(), "'");
 				delete scene;
@@ -69,7 +70,7 @@ namespace Saurobyte
 			else if(action == SceneActions::Change)
 			{
 				// Clear systems from entities
-				m_engine->getSystemPool().emptySystems();
+				m_world->getSystemPool().emptySystems();
 
 				SAUROBYTE_DEBUG_LOG("Changing to scene '", scene->getName(), "'");
 
@@ -77,7 +78,7 @@ namespace Saurobyte
 				for(auto itr = scene->getEntities().begin(); itr != scene->getEntities().end(); itr++)
 					itr->second->refresh();
 
-				// TODOm_engine->queueMessage(MessageData<std::string>("SceneLoad", scene->getName()));
+				m_world->queueMessage<std::string>("SceneLoad", scene->getName());
 			}
 		}
 
@@ -9,7 +9,7 @@
 
 namespace Saurobyte
 {
-	class Engine;
+	class World;
 	class ScenePool
 	{
 	private:
@@ -31,11 +31,11 @@ namespace Saurobyte
 		};
 		std::vector<SceneAction> m_pendingActions;
 
-		Engine *m_engine;
+		World *m_world;
 
 	public:
 
-		ScenePool(Engine *engine);
+		ScenePool(World *world);
 		~ScenePool();
 
 		Scene& createScene(const std::string &name);
@@ -0,0 +1,121 @@
+/*
+
+	The MIT License (MIT)
+
+	Copyright (c) 2014 by Jakob Larsson
+
+	Permission is hereby granted, free of charge, to any person obtaining 
+	a copy of this software and associated documentation files (the "Software"), 
+	to deal in the Software without restriction, including without limitation the 
+	rights to use, copy, modify, merge, publish, distribute, sublicense, and/or 
+	sell copies of the Software, and to permit persons to whom the Software is 
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in 
+	all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+	IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+#include <Saurobyte/SparseSet.hpp>
+#include <Saurobyte/Entity.hpp>
+#include <algorithm>
+
+namespace Saurobyte
+{
+	const std::size_t SparseSet::InvalidIndex = static_cast<std::size_t>(-1);
+
+	SparseSet::SparseSet(const ComponentType &type)
+		:
+		m_type(type),
+		m_chunkCapacity(std::max<std::size_t>(1, ChunkSize / type.size))
+	{
+
+	}
+	SparseSet::~SparseSet()
+	{
+		// Destroy remaining components, the owning entities may already be gone
+		for(std::size_t i = 0; i < m_entities.size(); i++)
+			m_type.destroy(getData(i));
+	}
+
+	void* SparseSet::allocate(Entity &entity)
+	{
+		std::size_t index = m_entities.size();
+
+		// Grab a new chunk if the current ones are full, component sizes are a multiple of their
+		// alignment so an aligned chunk keeps every component aligned
+		if(index / m_chunkCapacity >= m_chunks.size())
+			m_chunks.push_back(allocateAligned(m_chunkCapacity * m_type.size, m_type.alignment));
+
+		if(entity.getID() >= m_indices.size())
+			m_indices.resize(entity.getID() + 1, InvalidIndex);
+
+		m_indices[entity.getID()] = index;
+		m_entities.push_back(&entity);
+
+		return getData(index);
+	}
+	void SparseSet::remove(EntityID id)
+	{
+		std::size_t index = m_indices[id];
+		std::size_t last = m_entities.size() - 1;
+
+		m_type.destroy(getData(index));
+
+		// Fill the gap with the last component so the set stays packed
+		if(index != last)
+		{
+			unsigned char *lastData = getData(last);
+			m_type.moveConstruct(getData(index), lastData);
+			m_type.destroy(lastData);
+
+			m_entities[index] = m_entities[last];
+			m_indices[m_entities[index]->getID()] = index;
+		}
+
+		m_entities.pop_back();
+		m_indices[id] = InvalidIndex;
+	}
+
+	void* SparseSet::get(EntityID id)
+	{
+		return contains(id) ? getData(m_indices[id]) : nullptr;
+	}
+	bool SparseSet::contains(EntityID id) const
+	{
+		return id < m_indices.size() && m_indices[id] != InvalidIndex;
+	}
+
+	Entity* const* SparseSet::getChunkEntities(std::size_t chunk) const
+	{
+		return m_entities.data() + chunk * m_chunkCapacity;
+	}
+	std::size_t SparseSet::getChunkCount() const
+	{
+		return (m_entities.size() + m_chunkCapacity - 1) / m_chunkCapacity;
+	}
+	std::size_t SparseSet::getChunkEntityCount(std::size_t chunk) const
+	{
+		return std::min(m_chunkCapacity, m_entities.size() - chunk * m_chunkCapacity);
+	}
+	std::size_t SparseSet::getSize() const
+	{
+		return m_entities.size();
+	}
+	const ComponentType& SparseSet::getType() const
+	{
+		return m_type;
+	}
+
+	unsigned char* SparseSet::getData(std::size_t index)
+	{
+		return m_chunks[index / m_chunkCapacity].get() + (index % m_chunkCapacity) * m_type.size;
+	}
+};
@@ -0,0 +1,138 @@
+/*
+
+	The MIT License (MIT)
+
+	Copyright (c) 2014 by Jakob Larsson
+
+	Permission is hereby granted, free of charge, to any person obtaining 
+	a copy of this software and associated documentation files (the "Software"), 
+	to deal in the Software without restriction, including without limitation the 
+	rights to use, copy, modify, merge, publish, distribute, sublicense, and/or 
+	sell copies of the Software, and to permit persons to whom the Software is 
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in 
+	all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+	IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+#ifndef SAUROBYTE_SPARSE_SET_HPP
+#define SAUROBYTE_SPARSE_SET_HPP
+
+#include <Saurobyte/IdentifierTypes.hpp>
+#include <Saurobyte/ComponentType.hpp>
+#include <Saurobyte/NonCopyable.hpp>
+#include <Saurobyte/AlignedMemory.hpp>
+#include <vector>
+#include <memory>
+
+namespace Saurobyte
+{
+	class Entity;
+	class BaseComponent;
+
+	/*
+		SparseSet
+
+		Storage for all components of a single sparse component type (see
+		ComponentReflection::sparseStorage). Components are packed densely in
+		fixed size chunks, along with a lookup of their index by EntityID, so
+		adding and removing a component is O(1) and never moves the other
+		components of the entity. The set can be iterated on its own:
+
+			SparseSet &poisoned = entityPool.getSparseSet<PoisonComponent>();
+			for(std::size_t c = 0; c < poisoned.getChunkCount(); c++)
+			{
+				PoisonComponent *poison = poisoned.getComponents<PoisonComponent>(c);
+				for(std::size_t i = 0; i < poisoned.getChunkEntityCount(c); i++)
+					poison[i].tick();
+			}
+
+		Removing a component moves the last component of the set into its
+		place, so pointers are only valid until the next removal.
+
+	*/
+	class SparseSet : public NonCopyable
+	{
+	public:
+
+		// Size in bytes of a single chunk of component memory
+		static const std::size_t ChunkSize = 16 * 1024;
+
+		explicit SparseSet(const ComponentType &type);
+		~SparseSet();
+
+		/**
+		 * Allocates a component at the end of the set for the specified entity, the component is left unconstructed
+		 * @param  entity The entity that will own the component, which must not have one already
+		 * @return        Pointer to the component memory
+		 */
+		void* allocate(Entity &entity);
+
+		/**
+		 * Destroys the component of an entity, the last component in the set is moved into its place
+		 * @param id The entity owning the component
+		 */
+		void remove(EntityID id);
+
+		/**
+		 * Retrieves the raw storage of the component of an entity
+		 * @param  id The entity owning the component
+		 * @return    Pointer to the component memory, or nullptr if the entity has no component in this set
+		 */
+		void* get(EntityID id);
+		bool contains(EntityID id) const;
+
+		/**
+		 * Retrieves the components of a chunk, the chunk holds getChunkEntityCount(chunk) components
+		 * @param  chunk Index of the chunk
+		 * @return       Pointer to the first component in the chunk
+		 */
+		template<typename TType> TType* getComponents(std::size_t chunk)
+		{
+			return reinterpret_cast<TType*>(m_chunks[chunk].get());
+		};
+
+		/**
+		 * Retrieves the entities owning the components of a chunk, in the same order as the components
+		 * @param  chunk Index of the chunk
+		 * @return       Pointer to the first entity in the chunk
+		 */
+		Entity* const* getChunkEntities(std::size_t chunk) const;
+
+		std::size_t getChunkCount() const;
+		std::size_t getChunkEntityCount(std::size_t chunk) const;
+
+		// Amount of components in the set
+		std::size_t getSize() const;
+		const ComponentType& getType() const;
+
+	private:
+
+		typedef AlignedBuffer ChunkPtr;
+
+		static const std::size_t InvalidIndex;
+
+		const ComponentType &m_type;
+
+		std::size_t m_chunkCapacity;
+		std::vector<ChunkPtr> m_chunks;
+
+		// The owner of every component, densely packed
+		std::vector<Entity*> m_entities;
+
+		// Index of the component of every entity, indexed by EntityID
+		std::vector<std::size_t> m_indices;
+
+		unsigned char* getData(std::size_t index);
+	};
+};
+
+#endif
@@ -0,0 +1,269 @@
+/*
+
+	The MIT License (MIT)
+
+	Copyright (c) 2014 by Jakob Larsson
+
+	Permission is hereby granted, free of charge, to any person obtaining 
+	a copy of this software and associated documentation files (the "Software"), 
+	to deal in the Software without restriction, including without limitation the 
+	rights to use, copy, modify, merge, publish, distribute, sublicense, and/or 
+	sell copies of the Software, and to permit persons to whom the Software is 
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in 
+	all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+	IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+#include <Saurobyte/SpatialGrid.hpp>
+#include <Saurobyte/World.hpp>
+#include <Saurobyte/Entity.hpp>
+#include <Saurobyte/Components/TransformComponent.hpp>
+#include <cmath>
+#include <algorithm>
+
+namespace Saurobyte
+{
+	namespace
+	{
+		// Cell coordinates are packed into 21 bits each, cells past that range are folded into the
+		// outermost ones, which only costs some extra position checks
+		const std::int64_t CellCoordinateBias = 1 << 20;
+		const std::uint64_t CellCoordinateMask = (1 << 21) - 1;
+
+		// Regions checked against the positions in the visited cells, borders included
+		struct BoxRegion
+		{
+			const Vector3f &minPoint;
+			const Vector3f &maxPoint;
+
+			explicit BoxRegion(const BoundingBox &box) : minPoint(box.getMinPoint()), maxPoint(box.getMaxPoint()) {};
+
+			bool contains(const Vector3f &position) const
+			{
+				return
+					position.x >= minPoint.x && position.x <= maxPoint.x &&
+					position.y >= minPoint.y && position.y <= maxPoint.y &&
+					position.z >= minPoint.z && position.z <= maxPoint.z;
+			};
+		};
+		struct SphereRegion
+		{
+			Vector3f center;
+			float radiusSquared;
+
+			SphereRegion(const Vector3f &sphereCenter, float radius) : center(sphereCenter), radiusSquared(radius * radius) {};
+
+			bool contains(const Vector3f &position) const
+			{
+				float x = position.x - center.x;
+				float y = position.y - center.y;
+				float z = position.z - center.z;
+				return x * x + y * y + z * z <= radiusSquared;
+			};
+		};
+	}
+
+	SpatialGrid::SpatialGrid(World *world, float cellSize)
+		:
+		m_cellSize(cellSize),
+		m_lastVersion(0),
+		m_world(world)
+	{
+
+	}
+
+	void SpatialGrid::update()
+	{
+		unsigned int version = BaseComponent::getCurrentVersion();
+		unsigned int lastVersion = m_lastVersion;
+
+		m_world->view<TransformComponent>().each([this, lastVersion](Entity &entity, TransformComponent &transform)
+		{
+			// Transforms are stamped when written, including children moved along with their parents
+			if(transform.getVersion() <= lastVersion)
+				return;
+
+			const Matrix4 &worldTransform = transform.getTransform();
+			Vector3f position(worldTransform[3][0], worldTransform[3][1], worldTransform[3][2]);
+
+			auto iter = m_records.find(entity.getID());
+			if(iter == m_records.end())
+			{
+				insert(entity.getID(), &entity, position, m_records[entity.getID()]);
+				return;
+			}
+
+			Record &record = iter->second;
+
+			// Entities staying in their cell are only written to
+			CellKey cell = getCellKey(
+				getCellCoordinate(position.x),
+				getCellCoordinate(position.y),
+				getCellCoordinate(position.z));
+			if(cell == record.cell)
+			{
+				CellEntry &entry = m_cells[cell][record.index];
+				entry.entity = &entity;
+				entry.position = position;
+			}
+			else
+			{
+				remove(record);
+				insert(entity.getID(), &entity, position, record);
+			}
+		});
+
+		// Writes made after the update are newer than the positions in the grid
+		m_lastVersion = version;
+		BaseComponent::advanceVersion();
+	}
+
+	void SpatialGrid::query(const BoundingBox &region, std::vector<Entity*> &entities)
+	{
+		queryCells(region, BoxRegion(region), entities);
+	}
+	void SpatialGrid::query(const Vector3f &center, float radius, std::vector<Entity*> &entities)
+	{
+		queryCells(BoundingBox(center, radius * 2, radius * 2, radius * 2), SphereRegion(center, radius), entities);
+	}
+
+	template<typename TRegion> void SpatialGrid::queryCells(
+		const BoundingBox &bounds,
+		const TRegion &region,
+		std::vector<Entity*> &entities)
+	{
+		const Vector3f &minPoint = bounds.getMinPoint();
+		const Vector3f &maxPoint = bounds.getMaxPoint();
+
+		std::int64_t minX = getCellCoordinate(minPoint.x), maxX = getCellCoordinate(maxPoint.x);
+		std::int64_t minY = getCellCoordinate(minPoint.y), maxY = getCellCoordinate(maxPoint.y);
+		std::int64_t minZ = getCellCoordinate(minPoint.z), maxZ = getCellCoordinate(maxPoint.z);
+
+		// Regions spanning more cells than there are occupied ones are cheaper to check cell by cell
+		double regionCells = double(maxX - minX + 1) * double(maxY - minY + 1) * double(maxZ - minZ + 1);
+		if(regionCells > m_cells.size())
+		{
+			for(auto itr = m_cells.begin(); itr != m_cells.end(); itr++)
+			{
+				const std::vector<CellEntry> &cell = itr->second;
+				for(std::size_t i = 0; i < cell.size(); i++)
+				{
+					if(region.contains(cell[i].position))
+						entities.push_back(cell[i].entity);
+				}
+			}
+
+			return;
+		}
+
+		for(std::int64_t x = minX; x <= maxX; x++)
+		{
+			for(std::int64_t y = minY; y <= maxY; y++)
+			{
+				for(std::int64_t z = minZ; z <= maxZ; z++)
+				{
+					auto iter = m_cells.find(getCellKey(x, y, z));
+					if(iter == m_cells.end())
+						continue;
+
+					const std::vector<CellEntry> &cell = iter->second;
+					for(std::size_t i = 0; i < cell.size(); i++)
+					{
+						if(region.contains(cell[i].position))
+							entities.push_back(cell[i].entity);
+					}
+				}
+			}
+		}
+	}
+
+	void SpatialGrid::setCellSize(float cellSize)
+	{
+		m_cellSize = cellSize;
+		m_cells.clear();
+		m_records.clear();
+		m_lastVersion = 0;
+	}
+	float SpatialGrid::getCellSize() const
+	{
+		return m_cellSize;
+	}
+
+	std::size_t SpatialGrid::getSize() const
+	{
+		return m_records.size();
+	}
+
+	std::int64_t SpatialGrid::getCellCoordinate(float position) const
+	{
+		// Clamp before converting, casting an infinite or out of range value is undefined. Infinite
+		// bounds thereby span every cell, which queryCells handles by visiting the occupied ones.
+		double cell = std::floor(static_cast<double>(position) / m_cellSize);
+		if(std::isnan(cell))
+			return 0;
+
+		cell = std::max(cell, static_cast<double>(-CellCoordinateBias));
+		cell = std::min(cell, static_cast<double>(CellCoordinateBias - 1));
+		return static_cast<std::int64_t>(cell);
+	}
+	SpatialGrid::CellKey SpatialGrid::getCellKey(std::int64_t x, std::int64_t y, std::int64_t z) const
+	{
+		return
+			(static_cast<std::uint64_t>(x + CellCoordinateBias) & CellCoordinateMask) |
+			((static_cast<std::uint64_t>(y + CellCoordinateBias) & CellCoordinateMask) << 21) |
+			((static_cast<std::uint64_t>(z + CellCoordinateBias) & CellCoordinateMask) << 42);
+	}
+
+	void SpatialGrid::insert(EntityID id, Entity *entity, const Vector3f &position, Record &record)
+	{
+		record.cell = getCellKey(
+			getCellCoordinate(position.x),
+			getCellCoordinate(position.y),
+			getCellCoordinate(position.z));
+
+		std::vector<CellEntry> &cell = m_cells[record.cell];
+		record.index = cell.size();
+
+		CellEntry entry = { id, entity, position };
+		cell.push_back(entry);
+	}
+	void SpatialGrid::remove(const Record &record)
+	{
+		auto iter = m_cells.find(record.cell);
+		std::vector<CellEntry> &cell = iter->second;
+
+		// Swap in the last entry of the cell and point its record to the new index
+		if(record.index != cell.size() - 1)
+		{
+			cell[record.index] = cell.back();
+			m_records[cell[record.index].id].index = record.index;
+		}
+		cell.pop_back();
+
+		if(cell.empty())
+			m_cells.erase(iter);
+	}
+	void SpatialGrid::removeEntity(const Entity &entity)
+	{
+		auto iter = m_records.find(entity.getID());
+		if(iter == m_records.end())
+			return;
+
+		remove(iter->second);
+		m_records.erase(iter);
+	}
+	void SpatialGrid::refreshEntity(Entity &entity)
+	{
+		if(!m_records.empty() && !entity.hasComponent<TransformComponent>())
+			removeEntity(entity);
+	}
+};
@@ -0,0 +1,150 @@
+/*
+
+	The MIT License (MIT)
+
+	Copyright (c) 2014 by Jakob Larsson
+
+	Permission is hereby granted, free of charge, to any person obtaining 
+	a copy of this software and associated documentation files (the "Software"), 
+	to deal in the Software without restriction, including without limitation the 
+	rights to use, copy, modify, merge, publish, distribute, sublicense, and/or 
+	sell copies of the Software, and to permit persons to whom the Software is 
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in 
+	all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+	IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+#ifndef SAUROBYTE_SPATIAL_GRID_HPP
+#define SAUROBYTE_SPATIAL_GRID_HPP
+
+#include <Saurobyte/IdentifierTypes.hpp>
+#include <Saurobyte/NonCopyable.hpp>
+#include <Saurobyte/BoundingBox.hpp>
+#include <Saurobyte/Math/Vector3.hpp>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+
+namespace Saurobyte
+{
+	class World;
+	class Entity;
+
+	/*
+		SpatialGrid
+
+		Index of the world positions of entities with a TransformComponent,
+		used to find the entities within a region (see World::sendMessageInRegion):
+
+			std::vector<Entity*> nearby;
+			world.getSpatialGrid().query(center, 5.f, nearby);
+
+		Space is divided into cubic cells, which only exist while entities are
+		in them. Moving an entity within its cell is a single write, and a
+		query only visits the cells overlapping the region, so its cost grows
+		with the entities around the region rather than all entities.
+
+		The grid is updated once per frame by World::frame, right after the
+		transform hierarchy. Only transforms changed since the previous update
+		(see BaseComponent::getVersion) are looked at, and entities are removed
+		as they die or lose their TransformComponent. Queries don't modify the
+		grid, so systems running in parallel may query it.
+
+	*/
+	class SpatialGrid : public NonCopyable
+	{
+	public:
+
+		/**
+		 * @param world    The world whose entities are indexed
+		 * @param cellSize Length of the sides of the cells, a bit above the usual query radius works well
+		 */
+		SpatialGrid(World *world, float cellSize);
+
+		/**
+		 * Brings the grid up to date with the world transforms changed since the previous update. Called by
+		 * World::frame, call it again when a query needs positions changed earlier in the same frame. Must be
+		 * called from the thread ticking the world, and never while systems run in parallel.
+		 */
+		void update();
+
+		/**
+		 * Finds the entities whose position is within a box, borders included
+		 * @param region   The box to search
+		 * @param entities Vector the entities are appended to
+		 */
+		void query(const BoundingBox &region, std::vector<Entity*> &entities);
+		/**
+		 * Finds the entities whose position is within a sphere, borders included
+		 * @param center   Center of the sphere
+		 * @param radius   Radius of the sphere
+		 * @param entities Vector the entities are appended to
+		 */
+		void query(const Vector3f &center, float radius, std::vector<Entity*> &entities);
+
+		// Changing the cell size rebuilds the grid on the next update
+		void setCellSize(float cellSize);
+		float getCellSize() const;
+
+		// Amount of entities in the grid, as of the last update
+		std::size_t getSize() const;
+
+	private:
+
+		// Entities leave the grid during the frame cleanup of the EntityPool
+		friend class EntityPool;
+
+		typedef std::uint64_t CellKey;
+
+		struct CellEntry
+		{
+			EntityID id;
+			Entity *entity;
+			Vector3f position;
+		};
+		std::unordered_map<CellKey, std::vector<CellEntry> > m_cells;
+
+		// Where every entity is stored, by EntityID
+		struct Record
+		{
+			CellKey cell;
+			std::size_t index;
+		};
+		std::unordered_map<EntityID, Record> m_records;
+
+		float m_cellSize;
+
+		// Change version of the last update, older transforms are already in the grid
+		unsigned int m_lastVersion;
+
+		World *m_world;
+
+		std::int64_t getCellCoordinate(float position) const;
+		CellKey getCellKey(std::int64_t x, std::int64_t y, std::int64_t z) const;
+
+		// Visits the cells overlapping the bounds, appending the entities within the region
+		template<typename TRegion> void queryCells(
+			const BoundingBox &bounds,
+			const TRegion &region,
+			std::vector<Entity*> &entities);
+
+		void insert(EntityID id, Entity *entity, const Vector3f &position, Record &record);
+		void remove(const Record &record);
+
+		// Removes a dead entity from the grid
+		void removeEntity(const Entity &entity);
+		// Removes an entity from the grid if it lost its TransformComponent
+		void refreshEntity(Entity &entity);
+	};
+};
+
+#endif
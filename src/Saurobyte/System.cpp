@@ -1,88 +1,461 @@
 #include <Saurobyte/System.hpp>
 #include <Saurobyte/Entity.hpp>
 #include <Saurobyte/Engine.hpp>
+#include <Saurobyte/World.hpp>
+#include <Saurobyte/ThreadPool.hpp>
+#include <algorithm>
+#include <chrono>
 
 namespace Saurobyte
 {
+	const std::size_t BaseSystem::InvalidIndex;
 
 	BaseSystem::BaseSystem(Engine *engineInstance, TypeID typeID)
 		:
-		MessageHandler(&engineInstance->getMessageCentral()),
+		BaseSystem(&engineInstance->getWorld(), typeID)
+	{
+		engine = engineInstance;
+	}
+	BaseSystem::BaseSystem(World *worldInstance, TypeID typeID)
+		:
+		MessageHandler(&worldInstance->getMessageCentral()),
+		m_processedCount(0),
+		m_declaredAccess(false),
+		m_chunkSize(0),
 		m_systemType(typeID),
 		m_isActive(true),
-		engine(engineInstance)
+		m_systemIndex(InvalidIndex),
+		m_lastVersion(0),
+		m_lapVersion(0),
+		m_time(0),
+		m_lastRunTime(0),
+		m_updateInterval(1),
+		m_skippedFrames(0),
+		m_updatePeriod(0),
+		m_nextUpdate(0),
+		m_priority(Priority::Medium),
+		m_sliceBegin(0),
+		m_sliceSize(0),
+		m_entityCost(0),
+		engine(nullptr),
+		world(worldInstance)
 	{
 
 	}
 
 	void BaseSystem::addRequirement(const std::vector<TypeID> &componentIDs)
 	{
-		m_wantedEntities.push_back(componentIDs);
+		m_wantedEntities.push_back(ComponentType::createSignature(componentIDs));
+		m_readAccess |= m_wantedEntities.back();
+
+		// Archetypes matched before may not match anymore
+		world->getSystemPool().invalidateMatches();
+	}
+	void BaseSystem::addReadAccess(const std::vector<TypeID> &componentIDs)
+	{
+		m_readAccess |= ComponentType::createSignature(componentIDs);
+		m_declaredAccess = true;
+	}
+	void BaseSystem::addWriteAccess(const std::vector<TypeID> &componentIDs)
+	{
+		m_writeAccess |= ComponentType::createSignature(componentIDs);
+		m_declaredAccess = true;
+	}
+	bool BaseSystem::conflictsWith(const BaseSystem &other) const
+	{
+		if(!m_declaredAccess || !other.m_declaredAccess)
+			return true;
+
+		return
+			(m_writeAccess & (other.m_readAccess | other.m_writeAccess)).any() ||
+			(other.m_writeAccess & m_readAccess).any();
+	}
+	bool BaseSystem::hasDeclaredAccess() const
+	{
+		return m_declaredAccess;
 	}
 
 
 
 	void BaseSystem::removeEntity(Entity &entity, bool wasKilled)
 	{
-		auto itr = m_monitoredEntities.find(entity.getID());
-		if(itr != m_monitoredEntities.end())
+		if(contains(entity))
 		{
-			m_monitoredEntities.erase(itr);
+			detachEntity(m_entityIndices[entity.getID()]);
 
 			if(wasKilled)
-				onKill(entity);
+				m_killedEntities.push_back(&entity);
 
-			onDetach(entity);
+			m_detachedEntities.push_back(&entity);
+		}
+	}
+	void BaseSystem::refreshEntity(Entity &entity)
+	{
+		updateMembership(entity, matches(entity.getSignature()));
+	}
+	void BaseSystem::updateMembership(Entity &entity, bool match)
+	{
+		bool monitored = contains(entity);
 
+		// A match was found and the entity is not already monitored
+		if(match && !monitored)
+		{
+			attachEntity(entity);
+			m_attachedEntities.push_back(&entity);
+		}
 
+		// If the entity is monitored, but no component matches were found, stop monitoring it
+		else if(!match && monitored)
+		{
+			detachEntity(m_entityIndices[entity.getID()]);
+			m_detachedEntities.push_back(&entity);
 		}
+		else if(match)
+			m_changedEntities.push_back(&entity);
 	}
-	void BaseSystem::refreshEntity(Entity &entity)
+	void BaseSystem::deliverChanges()
+	{
+		// Observers only mark entities dirty, membership changes caused by them are
+		// queued in the next round of EntityPool::frameCleanup.
+		if(!m_killedEntities.empty())
+			onEntitiesKilled(ArrayView<Entity*>(m_killedEntities.data(), m_killedEntities.size()));
+		if(!m_detachedEntities.empty())
+			onEntitiesDetached(ArrayView<Entity*>(m_detachedEntities.data(), m_detachedEntities.size()));
+		if(!m_attachedEntities.empty())
+			onEntitiesAttached(ArrayView<Entity*>(m_attachedEntities.data(), m_attachedEntities.size()));
+		if(!m_changedEntities.empty())
+			onEntitiesChanged(ArrayView<Entity*>(m_changedEntities.data(), m_changedEntities.size()));
+
+		m_killedEntities.clear();
+		m_detachedEntities.clear();
+		m_attachedEntities.clear();
+		m_changedEntities.clear();
+	}
+	void BaseSystem::onEntitiesAttached(const ArrayView<Entity*> &entities)
+	{
+		for(std::size_t i = 0; i < entities.size(); i++)
+			onAttach(*entities[i]);
+	}
+	void BaseSystem::onEntitiesDetached(const ArrayView<Entity*> &entities)
+	{
+		for(std::size_t i = 0; i < entities.size(); i++)
+			onDetach(*entities[i]);
+	}
+	void BaseSystem::onEntitiesKilled(const ArrayView<Entity*> &entities)
+	{
+		for(std::size_t i = 0; i < entities.size(); i++)
+			onKill(*entities[i]);
+	}
+	void BaseSystem::attachEntity(Entity &entity)
+	{
+		if(entity.getID() >= m_entityIndices.size())
+			m_entityIndices.resize(entity.getID() + 1, InvalidIndex);
+
+		m_entityIndices[entity.getID()] = m_monitoredEntities.size();
+		m_monitoredEntities.push_back(&entity);
+		m_lastProcessed.push_back(m_time);
+
+		if(m_systemIndex != InvalidIndex)
+			entity.m_systems.set(m_systemIndex);
+
+		if(entity.isActive() && !entity.isSleeping())
+			swapEntities(m_monitoredEntities.size() - 1, m_processedCount++);
+	}
+	void BaseSystem::detachEntity(std::size_t index)
+	{
+		// Keep the processed entities packed, moving the entity past them first
+		if(index < m_processedCount)
+		{
+			swapEntities(index, --m_processedCount);
+			index = m_processedCount;
+		}
+
+		// Swap and pop, moving the last entity into the gap
+		Entity &entity = *m_monitoredEntities[index];
+		m_entityIndices[entity.getID()] = InvalidIndex;
+		if(m_systemIndex != InvalidIndex)
+			entity.m_systems.reset(m_systemIndex);
+
+		Entity *last = m_monitoredEntities.back();
+		double lastProcessed = m_lastProcessed.back();
+		m_monitoredEntities.pop_back();
+		m_lastProcessed.pop_back();
+
+		if(index < m_monitoredEntities.size())
+		{
+			m_monitoredEntities[index] = last;
+			m_lastProcessed[index] = lastProcessed;
+			m_entityIndices[last->getID()] = index;
+		}
+	}
+	void BaseSystem::swapEntities(std::size_t first, std::size_t second)
+	{
+		if(first == second)
+			return;
+
+		std::swap(m_monitoredEntities[first], m_monitoredEntities[second]);
+		std::swap(m_lastProcessed[first], m_lastProcessed[second]);
+		m_entityIndices[m_monitoredEntities[first]->getID()] = first;
+		m_entityIndices[m_monitoredEntities[second]->getID()] = second;
+	}
+	void BaseSystem::updateProcessing(Entity &entity)
 	{
-		auto itr = m_monitoredEntities.find(entity.getID());
-		bool atleastOneMatch = false;
+		if(!contains(entity))
+			return;
+
+		std::size_t index = m_entityIndices[entity.getID()];
+		bool processed = entity.isActive() && !entity.isSleeping();
 
+		if(processed && index >= m_processedCount)
+			swapEntities(index, m_processedCount++);
+		else if(!processed && index < m_processedCount)
+			swapEntities(index, --m_processedCount);
+	}
+	bool BaseSystem::contains(const Entity &entity) const
+	{
+		return entity.getID() < m_entityIndices.size() && m_entityIndices[entity.getID()] != InvalidIndex;
+	}
+	bool BaseSystem::matches(const ComponentSignature &signature) const
+	{
 		for(std::size_t i = 0; i < m_wantedEntities.size(); i++)
 		{
-			bool matchingComponents = true;
-			for(std::size_t c = 0; c < m_wantedEntities[i].size(); c++)
+			if((signature & m_wantedEntities[i]) == m_wantedEntities[i])
+				return true;
+		}
+
+		return false;
+	}
+
+	void BaseSystem::processEntities(ThreadPool *threadPool)
+	{
+		typedef std::chrono::steady_clock SliceClock;
+		SliceClock::time_point sliceStart = SliceClock::now();
+
+		std::size_t entityCount = m_processedCount;
+		std::size_t begin = 0;
+		std::size_t count = entityCount;
+
+		// Time sliced systems continue round-robin where the previous slice ended
+		if(isTimeSliced())
+		{
+			begin = m_sliceBegin < entityCount ? m_sliceBegin : 0;
+			count = std::min(m_sliceSize, entityCount);
+			m_sliceBegin = entityCount == 0 ? 0 : (begin + count) % entityCount;
+
+			if(begin == 0)
+				beginLap();
+		}
+
+		std::size_t end = std::min(begin + count, entityCount);
+		processRange(threadPool, begin, end);
+
+		// The slice wrapped around, the rest of it belongs to the next lap
+		if(count > end - begin)
+		{
+			beginLap();
+			processRange(threadPool, 0, count - (end - begin));
+		}
+
+		if(isTimeSliced() && count > 0)
+		{
+			// Smooth out the measured cost, so a single slow frame doesn't shrink the next slices too much
+			double entityCost = std::chrono::duration<double>(SliceClock::now() - sliceStart).count() / count;
+			m_entityCost = m_entityCost > 0 ? m_entityCost * 0.75 + entityCost * 0.25 : entityCost;
+		}
+
+		for(std::size_t i = 0; i < m_activeThreads.size(); i++)
+		{
+			if(m_activeThreads[i])
 			{
-				if(!entity.hasComponent(m_wantedEntities[i][c]))
-				{
-					matchingComponents = false;
-					break;
-				}
+				m_activeThreads[i] = false;
+				postProcessThread(i);
 			}
+		}
+	}
+	void BaseSystem::beginLap()
+	{
+		// Entities of the new lap were last processed during the previous lap, so changes are
+		// reported relative to its start rather than to the last slice
+		m_lastVersion = m_lapVersion;
+		m_lapVersion = BaseComponent::getCurrentVersion();
+	}
+	void BaseSystem::processRange(ThreadPool *threadPool, std::size_t begin, std::size_t end)
+	{
+		if(begin == end)
+			return;
 
-			// A match was found and the entity is not already monitored
-			if(matchingComponents)
+		if(m_chunkSize == 0)
+		{
+			for(std::size_t i = begin; i < end; i++)
 			{
-				atleastOneMatch = true;
-				if(itr == m_monitoredEntities.end())
+				Entity *entity = m_monitoredEntities[i];
+				if(shouldProcess(*entity))
 				{
-					m_monitoredEntities[entity.getID()] = &entity;
-					onAttach(entity);
-					return;
+					processEntity(*entity);
+					m_lastProcessed[i] = m_time;
 				}
 			}
 		}
 
-		// If the entity is monitored, but no component matches were found, stop monitoring it
-		if(itr != m_monitoredEntities.end() && !atleastOneMatch)
+		// Without threads everything is processed as a single chunk of the main thread
+		else if(threadPool == nullptr)
 		{
-			m_monitoredEntities.erase(itr);
-			onDetach(entity);
+			setThreadCount(1);
+			processChunk(begin, end, 0);
+		}
+		else
+		{
+			threadPool->parallelFor(end - begin, m_chunkSize,
+				[this, begin] (std::size_t chunkBegin, std::size_t chunkEnd, std::size_t threadIndex)
+			{
+				// Record structural changes rather than racing on the entity pool
+				CommandBuffer::Scope scope(&m_commandBuffers[threadIndex]);
+				World::Scope worldScope(*world);
+				processChunk(begin + chunkBegin, begin + chunkEnd, threadIndex);
+			});
 		}
 	}
+	void BaseSystem::processChunk(std::size_t begin, std::size_t end, std::size_t threadIndex)
+	{
+		// Only touched by its own thread, so no synchronization needed
+		if(!m_activeThreads[threadIndex])
+		{
+			m_activeThreads[threadIndex] = true;
+			preProcessThread(threadIndex);
+		}
 
-	void BaseSystem::processEntities()
+		for(std::size_t i = begin; i < end; i++)
+		{
+			Entity *entity = m_monitoredEntities[i];
+			if(shouldProcess(*entity))
+			{
+				processEntity(*entity);
+				m_lastProcessed[i] = m_time;
+			}
+		}
+	}
+	void BaseSystem::setThreadCount(std::size_t threadCount)
 	{
-		for(auto itr = m_monitoredEntities.begin(); itr != m_monitoredEntities.end(); itr++)
+		if(m_commandBuffers.size() != threadCount)
 		{
-			if(itr->second->isActive())
-				processEntity(*itr->second);
+			flushCommands();
+			m_commandBuffers.resize(threadCount);
+			m_activeThreads.resize(threadCount, false);
 		}
 	}
+	void BaseSystem::flushCommands()
+	{
+		for(std::size_t i = 0; i < m_commandBuffers.size(); i++)
+			m_commandBuffers[i].flush();
+	}
+
+	void BaseSystem::setParallelProcessing(bool parallel, std::size_t chunkSize)
+	{
+		m_chunkSize = parallel ? std::max<std::size_t>(chunkSize, 1) : 0;
+	}
+	bool BaseSystem::isParallelProcessing() const
+	{
+		return m_chunkSize > 0;
+	}
+
+	void BaseSystem::setUpdateInterval(unsigned int frames)
+	{
+		m_updateInterval = std::max(frames, 1u);
+	}
+	void BaseSystem::setUpdateRate(float rate)
+	{
+		m_updatePeriod = rate > 0 ? 1.0 / rate : 0;
+		m_nextUpdate = m_time;
+	}
+	bool BaseSystem::advanceTime(float delta)
+	{
+		m_time += delta;
+
+		if(++m_skippedFrames < m_updateInterval)
+			return false;
+
+		return m_updatePeriod <= 0 || m_time >= m_nextUpdate;
+	}
+	void BaseSystem::useTurn()
+	{
+		if(m_updatePeriod > 0)
+		{
+			// Keep a steady rate, without trying to catch up after long frames
+			m_nextUpdate += m_updatePeriod;
+			if(m_nextUpdate <= m_time)
+				m_nextUpdate = m_time + m_updatePeriod;
+		}
+
+		m_skippedFrames = 0;
+	}
+
+	void BaseSystem::setTimeBudget(const Time &budget)
+	{
+		m_timeBudget = budget;
+	}
+	bool BaseSystem::isTimeSliced() const
+	{
+		return m_timeBudget.asNanoseconds() > 0;
+	}
+	void BaseSystem::planSlice(double budget)
+	{
+		// Until the cost per entity is known, measure it on a small slice
+		const std::size_t initialSliceSize = 64;
+
+		if(m_entityCost <= 0)
+			m_sliceSize = initialSliceSize;
+		else
+			m_sliceSize = std::max<std::size_t>(static_cast<std::size_t>(budget / m_entityCost), 1);
+	}
+
+	void BaseSystem::setPriority(PriorityType priority)
+	{
+		m_priority = priority;
+	}
+	PriorityType BaseSystem::getPriority() const
+	{
+		return m_priority;
+	}
+	const Time& BaseSystem::getTimeBudget() const
+	{
+		return m_timeBudget;
+	}
+
+	float BaseSystem::getDelta() const
+	{
+		return static_cast<float>(m_time - m_lastRunTime);
+	}
+	float BaseSystem::getDelta(const Entity &entity) const
+	{
+		return static_cast<float>(m_time - m_lastProcessed[m_entityIndices[entity.getID()]]);
+	}
+
+	void BaseSystem::setChangeFilter(const std::vector<TypeID> &componentIDs)
+	{
+		// Versions of the filtered components are read, so systems writing them may not run alongside
+		m_changeFilter = componentIDs;
+		m_readAccess |= ComponentType::createSignature(componentIDs);
+	}
+	bool BaseSystem::hasChanged(const BaseComponent &component) const
+	{
+		return component.getVersion() > m_lastVersion;
+	}
+	bool BaseSystem::shouldProcess(Entity &entity)
+	{
+		if(!entity.isActive())
+			return false;
+		else if(m_changeFilter.empty())
+			return true;
+
+		for(std::size_t i = 0; i < m_changeFilter.size(); i++)
+		{
+			BaseComponent *component = entity.getComponent(m_changeFilter[i]);
+			if(component != nullptr && hasChanged(*component))
+				return true;
+		}
+
+		return false;
+	}
 
 	void BaseSystem::setActive(bool active)
 	{
@@ -92,16 +465,40 @@ namespace Saurobyte
 	void BaseSystem::clearSystem()
 	{
 		onClear();
+
+		if(m_systemIndex != InvalidIndex)
+		{
+			for(std::size_t i = 0; i < m_monitoredEntities.size(); i++)
+				m_monitoredEntities[i]->m_systems.reset(m_systemIndex);
+		}
+
 		m_monitoredEntities.clear();
+		m_entityIndices.clear();
+		m_lastProcessed.clear();
+		m_processedCount = 0;
+
+		// Pending notifications refer to entities the system no longer knows of
+		m_attachedEntities.clear();
+		m_detachedEntities.clear();
+		m_killedEntities.clear();
+		m_changedEntities.clear();
 	}
 
 	TypeID BaseSystem::getTypeID() const
 	{
 		return m_systemType;
 	}
-	const std::unordered_map<EntityID, Entity*>& BaseSystem::getEntities() const
+	std::size_t BaseSystem::getSystemIndex() const
+	{
+		return m_systemIndex;
+	}
+	ArrayView<Entity*> BaseSystem::getEntities() const
+	{
+		return ArrayView<Entity*>(m_monitoredEntities.data(), m_monitoredEntities.size());
+	}
+	ArrayView<Entity*> BaseSystem::getProcessedEntities() const
 	{
-		return m_monitoredEntities;
+		return ArrayView<Entity*>(m_monitoredEntities.data(), m_processedCount);
 	}
 	bool BaseSystem::isActive() const
 	{
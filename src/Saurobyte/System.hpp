@@ -2,39 +2,136 @@
 #define JL_SYSTEM_HPP
 
 #include <vector>
-#include <unordered_map>
 #include <string>
 #include <Saurobyte/IdentifierTypes.hpp>
+#include <Saurobyte/ArrayView.hpp>
+#include <Saurobyte/ComponentType.hpp>
+#include <Saurobyte/CommandBuffer.hpp>
 #include <Saurobyte/MessageHandler.hpp>
+#include <Saurobyte/Priority.hpp>
+#include <Saurobyte/Time.hpp>
 
 namespace Saurobyte
 {
 
 	class Engine;
+	class World;
 	class Entity;
+	class ThreadPool;
 	class BaseSystem : public MessageHandler
 	{
 	private:
 
 		friend class SystemPool;
 
-		// List of component combinations this system wants
-		std::vector< std::vector<TypeID> > m_wantedEntities;
-		std::unordered_map<EntityID, Entity*> m_monitoredEntities;
+		// List of component combinations this system wants, compiled into signatures
+		std::vector<ComponentSignature> m_wantedEntities;
+
+		// Monitored entities packed densely for linear iteration, with an
+		// EntityID indexed lookup of their position for O(1) removal. The first
+		// m_processedCount entities are processed, the rest are sleeping or inactive.
+		std::vector<Entity*> m_monitoredEntities;
+		std::vector<std::size_t> m_entityIndices;
+		std::size_t m_processedCount;
+
+		// Component types accessed by the system, used for parallel scheduling
+		ComponentSignature m_readAccess;
+		ComponentSignature m_writeAccess;
+		bool m_declaredAccess;
+
+		// Amount of entities per parallel processing task, 0 if processed serially
+		std::size_t m_chunkSize;
+
+		// Deferred structural changes and whether or not preProcessThread has been
+		// called this frame, both indexed by ThreadPool::getThreadIndex
+		std::vector<CommandBuffer> m_commandBuffers;
+		std::vector<char> m_activeThreads;
 
 		const TypeID m_systemType;
 		bool m_isActive;
 
-		void processEntities();
+		// Index of the system within its SystemPool, also its bit in Entity::getSystems
+		std::size_t m_systemIndex;
+
+		// Component types of which at least one must have changed for an entity to be processed
+		std::vector<TypeID> m_changeFilter;
+
+		// Change version when the system last ran, see BaseComponent::getVersion. Time sliced systems
+		// only advance it once per round-robin lap, to the version at the start of the previous lap.
+		unsigned int m_lastVersion;
+		unsigned int m_lapVersion;
+
+		// Seconds passed while the system was active, at the last run and at the last time
+		// each monitored entity was processed (indexed like m_monitoredEntities).
+		double m_time;
+		double m_lastRunTime;
+		std::vector<double> m_lastProcessed;
+
+		// Update throttling, see setUpdateInterval and setUpdateRate
+		unsigned int m_updateInterval;
+		unsigned int m_skippedFrames;
+		double m_updatePeriod;
+		double m_nextUpdate;
+
+		// Time slicing, see setTimeBudget. The slice size is derived from the measured
+		// processing time per entity.
+		Time m_timeBudget;
+		PriorityType m_priority;
+		std::size_t m_sliceBegin;
+		std::size_t m_sliceSize;
+		double m_entityCost;
+
+		// Advances the time of the system by a frame, returns whether or not it is due to run this frame
+		bool advanceTime(float delta);
+		// Uses up the throttled turn of a due system that gets to run, systems skipped for lack
+		// of frame budget keep their turn and are due again next frame
+		void useTurn();
+		// Sets the amount of entities to process this frame, given the budget in seconds
+		void planSlice(double budget);
+
+		// Whether or not an entity is processed this frame, given the change filter
+		bool shouldProcess(Entity &entity);
+
+		void processEntities(ThreadPool *threadPool);
+		// Starts a round-robin lap of a time sliced system, moving its change version along
+		void beginLap();
+		void processRange(ThreadPool *threadPool, std::size_t begin, std::size_t end);
+		void processChunk(std::size_t begin, std::size_t end, std::size_t threadIndex);
+
+		// Prepares per-thread state for the specified amount of threads
+		void setThreadCount(std::size_t threadCount);
+		// Applies the structural changes made while running in parallel
+		void flushCommands();
+
+		// Attaches or detaches the entity depending on whether it matches the system
+		void updateMembership(Entity &entity, bool match);
+
+		void attachEntity(Entity &entity);
+		void detachEntity(std::size_t index);
+		void swapEntities(std::size_t first, std::size_t second);
+
+		// Entities attached, detached, killed or changed since the last delivery, see deliverChanges
+		std::vector<Entity*> m_attachedEntities;
+		std::vector<Entity*> m_detachedEntities;
+		std::vector<Entity*> m_killedEntities;
+		std::vector<Entity*> m_changedEntities;
+
+		// Calls the batch observers with the pending changes
+		void deliverChanges();
 
 	protected:
 
+		// The engine is nullptr for systems of headless worlds
 		Engine *engine;
-		
+		World *world;
+
 		BaseSystem(Engine *engine, TypeID typeID);
+		BaseSystem(World *world, TypeID typeID);
 
 	public:
 
+		static const std::size_t InvalidIndex = static_cast<std::size_t>(-1);
+
 		virtual ~BaseSystem() {};
 
 		/**
@@ -44,18 +141,133 @@ namespace Saurobyte
 		void addRequirement(const std::vector<TypeID> &componentIDs);
 
 		/**
-		 * Removes an entity from the system, removing it from the processing cycle of the system
+		 * Declares component types that this system reads. Systems that declare their component access may
+		 * run in parallel with other systems they don't conflict with. The component types of requirements
+		 * are implicitly read. Systems that declare nothing always run alone, on the main thread.
+		 *
+		 * Structural changes (adding or removing components, killing entities) made by systems running in
+		 * parallel are deferred until all systems running at the same time have finished. Systems running
+		 * in parallel may not send messages or create entities.
+		 * @param componentIDs Vector of the component ID's that are read
+		 */
+		void addReadAccess(const std::vector<TypeID> &componentIDs);
+		/**
+		 * Declares component types that this system writes, see addReadAccess
+		 * @param componentIDs Vector of the component ID's that are written
+		 */
+		void addWriteAccess(const std::vector<TypeID> &componentIDs);
+
+		/**
+		 * Checks if this system may not run at the same time as another system, which is the case if either
+		 * writes something the other accesses or either has not declared its component access
+		 * @param  other The other system
+		 * @return       Whether or not the systems must run one after the other
+		 */
+		bool conflictsWith(const BaseSystem &other) const;
+		/**
+		 * Returns whether or not the system has declared its component access, see addReadAccess
+		 */
+		bool hasDeclaredAccess() const;
+
+		/**
+		 * Enables processing of the entities of this system on all threads of the system pool. The entities
+		 * are split into chunks that are processed in parallel, so processEntity must be safe to call
+		 * concurrently for different entities. Structural changes are deferred as for parallel systems,
+		 * see addReadAccess.
+		 * @param parallel  Whether or not to process entities in parallel
+		 * @param chunkSize Amount of entities processed by a single task
+		 */
+		void setParallelProcessing(bool parallel, std::size_t chunkSize = 128);
+		bool isParallelProcessing() const;
+
+		/**
+		 * Runs the system only every few frames, i.e 2 runs it every other frame
+		 * @param frames Amount of frames between runs, 0 and 1 run the system every frame
+		 */
+		void setUpdateInterval(unsigned int frames);
+		/**
+		 * Limits how often the system runs per second. Combined with setUpdateInterval, both must allow the
+		 * system to run. Use getDelta for the time passed since the last run.
+		 * @param rate Runs per second, 0 to run the system every frame
+		 */
+		void setUpdateRate(float rate);
+
+		/**
+		 * Limits the time spent processing entities each frame. Time sliced systems process as many entities
+		 * as the budget allows, continuing round-robin where they left off the next frame. Use getDelta(entity)
+		 * for the time passed since an entity was last processed. When the frame budget of the system pool is
+		 * over-committed, systems with higher priority get their budget first (see SystemPool::setFrameBudget).
+		 * @param budget Processing time per frame, 0 to process all entities every frame
+		 */
+		void setTimeBudget(const Time &budget);
+		bool isTimeSliced() const;
+
+		/**
+		 * Sets the priority of the system when handing out the frame budget, see setTimeBudget
+		 * @param priority Priority level, see Priority
+		 */
+		void setPriority(PriorityType priority);
+		PriorityType getPriority() const;
+		const Time& getTimeBudget() const;
+
+		/**
+		 * Returns the seconds passed since the system last ran, while it was active
+		 */
+		float getDelta() const;
+		/**
+		 * Returns the seconds passed since the entity was last processed by the system, while it was active.
+		 * Equal to getDelta unless the system is time sliced or filters on changes.
+		 * @param entity An entity processed by the system
+		 */
+		float getDelta(const Entity &entity) const;
+
+		/**
+		 * Only processes entities of which at least one of the specified components has changed since the
+		 * last time the system ran, skipping untouched entities entirely. Components count as changed when
+		 * added to the entity or marked through BaseComponent::markChanged (i.e Entity::editComponent).
+		 * Changes the system makes itself are not reported back to it. The watched component types are
+		 * implicitly read, see addReadAccess.
+		 * @param componentIDs Vector of the component ID's to watch, empty to process every entity
+		 */
+		void setChangeFilter(const std::vector<TypeID> &componentIDs);
+
+		/**
+		 * Checks if a component has changed since the last time the system ran. Time sliced systems compare
+		 * against the start of their previous round-robin lap, so changes made after an entity was processed
+		 * aren't missed; they may however be reported once more, including the system's own writes.
+		 * @param  component The component to check
+		 * @return           Whether or not the component was written to since
+		 */
+		bool hasChanged(const BaseComponent &component) const;
+
+		/**
+		 * Removes an entity from the system, removing it from the processing cycle of the system. The
+		 * system is notified with the next batch of changes, see onEntitiesDetached.
 		 * @param entity    The entity to remove
 		 * @param wasKilled Whether or not the cause of removal was entity termination
 		 */
 		void removeEntity(Entity &entity, bool wasKilled);
 
 		/**
-		 * Updates the status of an entity within the system, making sure it has the sought after components
+		 * Updates the status of an entity within the system, making sure it has the sought after components.
+		 * The system is notified with the next batch of changes, see onEntitiesAttached.
 		 * @param entity The entity to update
 		 */
 		void refreshEntity(Entity &entity);
 
+		/**
+		 * Moves the entity in or out of the processed entities, depending on whether it's sleeping or inactive
+		 * @param entity The entity to update
+		 */
+		void updateProcessing(Entity &entity);
+
+		/**
+		 * Checks if a component signature satisfies any of the component combinations of this system
+		 * @param  signature The signature to test, i.e Entity::getSignature
+		 * @return           Whether or not an entity with the signature should be processed by this system
+		 */
+		bool matches(const ComponentSignature &signature) const;
+
 		/**
 		 * Sets the active status of the system, inactive systems will not run the processing cycle
 		 * @param active Boolean for whether or not the system should be active
@@ -76,6 +288,19 @@ namespace Saurobyte
 		 */
 		virtual void postProcess() {};
 
+		/**
+		 * Called on a thread before it processes its first entity of the frame, only used with parallel
+		 * processing. Allows for per-thread state such as accumulators.
+		 * @param threadIndex Index of the thread, see ThreadPool::getThreadIndex
+		 */
+		virtual void preProcessThread(std::size_t threadIndex) {};
+		/**
+		 * Called once all entities have been processed for every thread that called preProcessThread,
+		 * in ascending thread order on the thread running the system. Allows for merging per-thread state.
+		 * @param threadIndex Index of the thread, see ThreadPool::getThreadIndex
+		 */
+		virtual void postProcessThread(std::size_t threadIndex) {};
+
 
 		/**
 		 * Called when an entity is added for processing in the system
@@ -87,6 +312,31 @@ namespace Saurobyte
 		 * @param entity The removed entity
 		 */
 		virtual void onDetach(Entity &entity) {};
+		/**
+		 * Called once per frame with all entities that started being processed by the system since the
+		 * last call, packed contiguously. Calls onAttach for every entity unless overridden.
+		 * @param entities The added entities
+		 */
+		virtual void onEntitiesAttached(const ArrayView<Entity*> &entities);
+		/**
+		 * Called once per frame with all entities removed from the system since the last call. Killed
+		 * entities still have their components at this point. Calls onDetach for every entity unless overridden.
+		 * @param entities The removed entities
+		 */
+		virtual void onEntitiesDetached(const ArrayView<Entity*> &entities);
+		/**
+		 * Called before onEntitiesDetached with the removed entities that were killed. Calls onKill for
+		 * every entity unless overridden.
+		 * @param entities The killed entities
+		 */
+		virtual void onEntitiesKilled(const ArrayView<Entity*> &entities);
+		/**
+		 * Called once per frame with the processed entities that had components added or removed
+		 * while still being processed by the system
+		 * @param entities The changed entities
+		 */
+		virtual void onEntitiesChanged(const ArrayView<Entity*> &entities) {};
+
 		/**
 		 * Called when the system is cleared from all of its entities (e.g switching scenes), allowing for cleanup
 		 */
@@ -107,6 +357,12 @@ namespace Saurobyte
 		 * @return The unique identifier
 		 */
 		TypeID getTypeID() const;
+		/**
+		 * Returns the index of the system within its SystemPool, which is reused once the system has been
+		 * removed. Entities track the systems processing them by index, see Entity::getSystems.
+		 * @return The index, InvalidIndex if the system is not in a pool
+		 */
+		std::size_t getSystemIndex() const;
 		/**
 		 * Returns whether or not the system is active
 		 * @return Active status
@@ -114,9 +370,21 @@ namespace Saurobyte
 		bool isActive() const;
 
 		/**
-		 * Returns a read-only map of all the entities in the system
+		 * Returns whether or not the specified entity is processed by this system
+		 */
+		bool contains(const Entity &entity) const;
+
+		/**
+		 * Returns a read-only view of all the entities in the system, packed contiguously. The order
+		 * is deterministic but changes when entities are removed. The view is invalidated once
+		 * entities are attached or detached, which only happens at the start of a frame.
+		 */
+		ArrayView<Entity*> getEntities() const;
+		/**
+		 * Returns a read-only view of the entities that are processed, i.e not sleeping or inactive. They
+		 * come first in getEntities.
 		 */
-		const std::unordered_map<EntityID, Entity*>& getEntities() const;
+		ArrayView<Entity*> getProcessedEntities() const;
 
 	};
 
@@ -128,6 +396,10 @@ namespace Saurobyte
 			:
 			BaseSystem(engine, TypeIdGrabber::getUniqueTypeID<TType>())
 		{}
+		System(World *world)
+			:
+			BaseSystem(world, TypeIdGrabber::getUniqueTypeID<TType>())
+		{}
 		virtual ~System() {};
 	};
 };
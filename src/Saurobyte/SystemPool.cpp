@@ -1,13 +1,19 @@
 #include <Saurobyte/SystemPool.hpp>
 #include <Saurobyte/System.hpp>
+#include <Saurobyte/World.hpp>
+#include <Saurobyte/Logger.hpp>
+#include <algorithm>
+#include <limits>
+#include <thread>
 
 
 namespace Saurobyte
 {
-	SystemPool::SystemPool(Engine *engine)
+	SystemPool::SystemPool(World *world, std::size_t workerCount)
 		:
-		m_engine(engine)
+		m_world(world)
 	{
+		setWorkerCount(workerCount);
 	}
 	SystemPool::~SystemPool()
 	{
@@ -21,7 +27,22 @@ namespace Saurobyte
 		// Make sure the system doesn't exist, then add it
 		auto iter = m_systemPool.find(newSystem->getTypeID());
 		if(iter == m_systemPool.end())
+		{
+			// Reuse the index of a removed system if possible
+			std::size_t index = std::find(m_systemSlots.begin(), m_systemSlots.end(), nullptr) - m_systemSlots.begin();
+			if(index >= SAUROBYTE_MAX_SYSTEMS)
+				SAUROBYTE_FATAL_LOG("Exceeded the maximum amount of systems (", SAUROBYTE_MAX_SYSTEMS, "), see SAUROBYTE_MAX_SYSTEMS");
+
+			if(index == m_systemSlots.size())
+				m_systemSlots.push_back(newSystem);
+			else
+				m_systemSlots[index] = newSystem;
+
+			newSystem->m_systemIndex = index;
 			m_systemPool[newSystem->getTypeID()] = SystemPtr(newSystem);
+			m_systemOrder.push_back(newSystem);
+			invalidateMatches();
+		}
 	}
 	void SystemPool::removeSystem(TypeID id)
 	{
@@ -32,6 +53,17 @@ namespace Saurobyte
 		// return false.
 		if(iter != m_systemPool.end())
 		{
+			// Entities forget about the system right away, so its index can be reused
+			BaseSystem *system = iter->second.get();
+			ArrayView<Entity*> entities = system->getEntities();
+			for(std::size_t i = 0; i < entities.size(); i++)
+				entities[i]->m_systems.reset(system->m_systemIndex);
+
+			m_systemSlots[system->m_systemIndex] = nullptr;
+			system->m_systemIndex = BaseSystem::InvalidIndex;
+			invalidateMatches();
+
+			m_systemOrder.erase(std::find(m_systemOrder.begin(), m_systemOrder.end(), iter->second.get()));
 			m_pendingDeletes.push_back(std::move(iter->second));
 			m_systemPool.erase(iter);
 		}
@@ -62,26 +94,237 @@ namespace Saurobyte
 	}
 	void SystemPool::processSystems()
 	{
-		for(auto itr = m_systemPool.begin(); itr != m_systemPool.end(); itr++)
+		// Throttled systems keep track of time while skipping frames
+		float delta = m_world->getDelta();
+		m_activeSystems.clear();
+		for(std::size_t i = 0; i < m_systemOrder.size(); i++)
 		{
-			if(itr->second->isActive())
+			if(m_systemOrder[i]->isActive() && m_systemOrder[i]->advanceTime(delta))
+				m_activeSystems.push_back(m_systemOrder[i]);
+		}
+
+		// Only systems that actually run this frame use up their throttled turn
+		distributeFrameBudget();
+		for(std::size_t i = 0; i < m_activeSystems.size(); i++)
+			m_activeSystems[i]->useTurn();
+
+		// Deterministic fallback, run everything in order on this thread
+		if(m_threadPool == nullptr)
+		{
+			for(std::size_t i = 0; i < m_activeSystems.size(); i++)
+			{
+				BaseComponent::advanceVersion();
+				runSystem(*m_activeSystems[i], nullptr, false);
+			}
+
+			// Writes made between frames are newer than anything written by the systems
+			BaseComponent::advanceVersion();
+			return;
+		}
+
+		// Build the dependency graph, where each system depends on the conflicting systems
+		// before it. Every system is placed in the stage after its latest dependency.
+		std::size_t stageCount = 0;
+		m_systemStages.assign(m_activeSystems.size(), 0);
+		for(std::size_t i = 0; i < m_activeSystems.size(); i++)
+		{
+			for(std::size_t j = 0; j < i; j++)
+			{
+				if(m_activeSystems[i]->conflictsWith(*m_activeSystems[j]))
+					m_systemStages[i] = std::max(m_systemStages[i], m_systemStages[j] + 1);
+			}
+
+			stageCount = std::max(stageCount, m_systemStages[i] + 1);
+			m_activeSystems[i]->setThreadCount(m_threadPool->getThreadCount());
+		}
+
+		for(std::size_t stage = 0; stage < stageCount; stage++)
+		{
+			// The first system of a stage runs on this thread, which also makes sure systems
+			// that have not declared their access (and thus run alone) stay on the main thread.
+			BaseSystem *localSystem = nullptr;
+			bool concurrent = std::count(m_systemStages.begin(), m_systemStages.end(), stage) > 1;
+
+			// Systems of a stage never write what the others access, so they can share a change version
+			BaseComponent::advanceVersion();
+			ThreadPool *threadPool = m_threadPool.get();
+			for(std::size_t i = 0; i < m_activeSystems.size(); i++)
+			{
+				if(m_systemStages[i] != stage)
+					continue;
+
+				BaseSystem *system = m_activeSystems[i];
+				if(localSystem == nullptr)
+					localSystem = system;
+				else
+					m_threadPool->push([system, threadPool] () { runSystem(*system, threadPool, true); });
+			}
+
+			runSystem(*localSystem, threadPool, concurrent);
+			m_threadPool->wait();
+
+			for(std::size_t i = 0; i < m_activeSystems.size(); i++)
 			{
-				itr->second->preProcess();
-				itr->second->processEntities();
-				itr->second->postProcess();
+				if(m_systemStages[i] == stage)
+					m_activeSystems[i]->flushCommands();
 			}
 		}
+
+		BaseComponent::advanceVersion();
+	}
+	void SystemPool::runSystem(BaseSystem &system, ThreadPool *threadPool, bool concurrent)
+	{
+		// Structural changes of systems running alone are applied immediately
+		CommandBuffer *commands = concurrent ? &system.m_commandBuffers[threadPool->getThreadIndex()] : nullptr;
+		CommandBuffer::Scope scope(commands);
+		World::Scope worldScope(*system.world);
+
+		unsigned int version = BaseComponent::getCurrentVersion();
+
+		system.preProcess();
+		system.processEntities(threadPool);
+		system.postProcess();
+
+		// Changes of this run are not reported back to the system, time sliced systems advance per lap instead
+		if(!system.isTimeSliced())
+			system.m_lastVersion = version;
+		system.m_lastRunTime = system.m_time;
+	}
+
+	void SystemPool::distributeFrameBudget()
+	{
+		m_slicedSystems.clear();
+		for(std::size_t i = 0; i < m_activeSystems.size(); i++)
+		{
+			if(m_activeSystems[i]->isTimeSliced())
+				m_slicedSystems.push_back(m_activeSystems[i]);
+		}
+
+		std::stable_sort(m_slicedSystems.begin(), m_slicedSystems.end(),
+			[] (const BaseSystem *lhs, const BaseSystem *rhs) { return lhs->getPriority() > rhs->getPriority(); });
+
+		double remainingBudget = m_frameBudget.asNanoseconds() > 0 ?
+			m_frameBudget.asSeconds() : std::numeric_limits<double>::infinity();
+
+		for(std::size_t i = 0; i < m_slicedSystems.size(); i++)
+		{
+			BaseSystem *system = m_slicedSystems[i];
+			double budget = std::min<double>(system->getTimeBudget().asSeconds(), remainingBudget);
+			remainingBudget -= budget;
+
+			// Starved systems skip the frame, their entities get a longer delta next time
+			if(budget > 0)
+				system->planSlice(budget);
+			else
+				m_activeSystems.erase(std::find(m_activeSystems.begin(), m_activeSystems.end(), system));
+		}
+	}
+	void SystemPool::setFrameBudget(const Time &budget)
+	{
+		m_frameBudget = budget;
+	}
+	const Time& SystemPool::getFrameBudget() const
+	{
+		return m_frameBudget;
+	}
+
+	void SystemPool::setWorkerCount(std::size_t count)
+	{
+		if(count == 0)
+			m_threadPool.reset();
+		else if(count != getWorkerCount())
+			m_threadPool = std::unique_ptr<ThreadPool>(new ThreadPool(count));
+	}
+	std::size_t SystemPool::getWorkerCount() const
+	{
+		return m_threadPool == nullptr ? 0 : m_threadPool->getWorkerCount();
 	}
 
 	void SystemPool::removeEntityFromSystems(Entity &entity, bool wasKilled)
 	{
-		for(auto itr = m_systemPool.begin(); itr != m_systemPool.end(); itr++)
-			itr->second->removeEntity(entity, wasKilled);
+		// Copied, as removal clears the bits
+		SystemSignature systems = entity.getSystems();
+		for(std::size_t i = 0; i < m_systemSlots.size() && systems.any(); i++)
+		{
+			if(systems.test(i))
+			{
+				m_systemSlots[i]->removeEntity(entity, wasKilled);
+				systems.reset(i);
+			}
+		}
 	}
 	void SystemPool::refreshEntity(Entity &entity)
 	{
-		for(auto itr = m_systemPool.begin(); itr != m_systemPool.end(); itr++)
-			itr->second->refreshEntity(entity);
+		updateMembership(entity, getMatchingSystems(entity.getSignature()));
+	}
+	void SystemPool::refreshEntities(const std::vector<Entity*> &entities)
+	{
+		if(entities.empty())
+			return;
+
+		// Entities sharing a component setup match the same systems
+		const SystemSignature &matches = getMatchingSystems(entities.front()->getSignature());
+		for(std::size_t i = 0; i < entities.size(); i++)
+			updateMembership(*entities[i], matches);
+	}
+	void SystemPool::updateMembership(Entity &entity, const SystemSignature &matches)
+	{
+		// Systems the entity is in or should be in, all others are left untouched
+		SystemSignature affected = matches | entity.getSystems();
+		for(std::size_t i = 0; i < m_systemSlots.size() && affected.any(); i++)
+		{
+			if(affected.test(i))
+			{
+				m_systemSlots[i]->updateMembership(entity, matches.test(i));
+				affected.reset(i);
+			}
+		}
+	}
+	const SystemSignature& SystemPool::getMatchingSystems(const ComponentSignature &signature)
+	{
+		auto iter = m_signatureMatches.find(signature);
+		if(iter != m_signatureMatches.end())
+			return iter->second;
+
+		SystemSignature &matches = m_signatureMatches[signature];
+		for(std::size_t i = 0; i < m_systemSlots.size(); i++)
+		{
+			if(m_systemSlots[i] != nullptr && m_systemSlots[i]->matches(signature))
+				matches.set(i);
+		}
+
+		return matches;
+	}
+	void SystemPool::invalidateMatches()
+	{
+		m_signatureMatches.clear();
+
+		m_requiredComponents.reset();
+		for(std::size_t i = 0; i < m_systemSlots.size(); i++)
+		{
+			for(std::size_t j = 0; m_systemSlots[i] != nullptr && j < m_systemSlots[i]->m_wantedEntities.size(); j++)
+				m_requiredComponents |= m_systemSlots[i]->m_wantedEntities[j];
+		}
+	}
+	bool SystemPool::isRequired(const ComponentType &type) const
+	{
+		return m_requiredComponents.test(type.signatureBit);
+	}
+
+	void SystemPool::updateProcessing(Entity &entity)
+	{
+		const SystemSignature &systems = entity.getSystems();
+		for(std::size_t i = 0; i < m_systemSlots.size(); i++)
+		{
+			if(systems.test(i))
+				m_systemSlots[i]->updateProcessing(entity);
+		}
+	}
+	void SystemPool::deliverChanges()
+	{
+		// Every system gets all of its changes at once, in the order systems were added
+		for(std::size_t i = 0; i < m_systemOrder.size(); i++)
+			m_systemOrder[i]->deliverChanges();
 	}
 
 	void SystemPool::frameCleanup()
@@ -6,10 +6,11 @@
 #include <memory>
 #include <Saurobyte/IdentifierTypes.hpp>
 #include <Saurobyte/System.hpp>
+#include <Saurobyte/ThreadPool.hpp>
 
 namespace Saurobyte
 {
-	class Engine;
+	class World;
 	class Entity;
 	class SystemPool
 	{
@@ -20,11 +21,48 @@ namespace Saurobyte
 		std::unordered_map<TypeID, SystemPtr> m_systemPool;
 		std::vector<SystemPtr> m_pendingDeletes;
 
-		Engine *m_engine;
+		// Systems in the order they were added, which is the order they run in
+		std::vector<BaseSystem*> m_systemOrder;
+
+		// Systems by index (see BaseSystem::getSystemIndex), nullptr for free indices
+		std::vector<BaseSystem*> m_systemSlots;
+
+		// Systems matching each component setup, filled in lazily and discarded
+		// whenever systems or their requirements change.
+		std::unordered_map<ComponentSignature, SystemSignature> m_signatureMatches;
+
+		// Component types required by any system, see isRequired
+		ComponentSignature m_requiredComponents;
+
+		const SystemSignature& getMatchingSystems(const ComponentSignature &signature);
+		void updateMembership(Entity &entity, const SystemSignature &matches);
+
+		// Discards the cached matches, see BaseSystem::addRequirement
+		void invalidateMatches();
+		friend class BaseSystem;
+
+		// Workers running non-conflicting systems in parallel
+		std::unique_ptr<ThreadPool> m_threadPool;
+
+		// Schedule of the current frame, kept around to avoid reallocations
+		std::vector<BaseSystem*> m_activeSystems;
+		std::vector<std::size_t> m_systemStages;
+
+		// Time available to time sliced systems each frame, and those due to run this frame
+		Time m_frameBudget;
+		std::vector<BaseSystem*> m_slicedSystems;
+
+		// Hands out the frame budget to the time sliced systems about to run
+		void distributeFrameBudget();
+
+		// Runs the processing cycle of a system, deferring structural changes if other systems run concurrently
+		static void runSystem(BaseSystem &system, ThreadPool *threadPool, bool concurrent);
+
+		World *m_world;
 
 	public:
 
-		SystemPool(Engine *engine);
+		SystemPool(World *world, std::size_t workerCount);
 		~SystemPool();
 
 		void addSystem(BaseSystem *newSystem);
@@ -53,11 +91,56 @@ namespace Saurobyte
 		}
 		bool hasSystem(TypeID id);
 
+		// Updates which systems process the entities, the systems are notified of the
+		// changes in batches once deliverChanges is called. Only the systems processing
+		// the entity (see Entity::getSystems) or matching its component setup are visited.
 		void removeEntityFromSystems(Entity &entity, bool wasKilled = false);
 		void refreshEntity(Entity &entity);
+		// Refreshes entities that all share the same component setup
+		void refreshEntities(const std::vector<Entity*> &entities);
+		// Moves the entity in or out of the iteration of the systems, see Entity::sleep
+		void updateProcessing(Entity &entity);
+
+		/**
+		 * Returns whether or not any system requires the component type, entities don't need to be
+		 * refreshed when sparse components no system cares about are added or removed
+		 */
+		bool isRequired(const ComponentType &type) const;
+
+		/**
+		 * Notifies every system of the entities attached to, detached from or changed within it since
+		 * the last call, see BaseSystem::onEntitiesAttached. Called by EntityPool::frameCleanup.
+		 */
+		void deliverChanges();
 
 		void emptySystems();
+
+		/**
+		 * Runs all active systems. Systems are split into stages where no two systems of a stage conflict
+		 * (see BaseSystem::conflictsWith), and the systems of a stage run in parallel. A system always
+		 * runs after the conflicting systems added before it, so the result is the same as running the
+		 * systems one by one in the order they were added. Structural changes deferred by systems of a
+		 * stage are applied once the stage has finished, in the order the systems were added.
+		 */
 		void processSystems();
+
+		/**
+		 * Sets the amount of worker threads used to run systems in parallel, 0 runs all systems on the
+		 * main thread. Defaults to the worker count the owning World was created with.
+		 * @param count Amount of worker threads
+		 */
+		void setWorkerCount(std::size_t count);
+		std::size_t getWorkerCount() const;
+
+		/**
+		 * Limits the total processing time of all time sliced systems per frame (see BaseSystem::setTimeBudget).
+		 * If their budgets exceed it, systems with higher priority get their budget first and systems left
+		 * without any budget skip the frame.
+		 * @param budget Processing time per frame, 0 to give every system its full budget
+		 */
+		void setFrameBudget(const Time &budget);
+		const Time& getFrameBudget() const;
+
 		void frameCleanup();
 	};
 };
@@ -29,6 +29,7 @@ IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <Saurobyte/Entity.hpp>
 #include <Saurobyte/Message.hpp>
 #include <Saurobyte/Engine.hpp>
+#include <Saurobyte/Lua/LuaEnv_Entity.hpp>
 
 namespace Saurobyte
 {
@@ -75,18 +76,19 @@ namespace Saurobyte
 	void LuaSystem::onMessage(Message *message)
 	{
 
-		if(message->name == "ReloadLua")
+		if(message->id == "ReloadLua")
 		{
-			for(auto itr = getEntities().begin(); itr != getEntities().end(); itr++)
+			ArrayView<Entity*> entities = getEntities();
+			for(std::size_t i = 0; i < entities.size(); i++)
 			{
-				LuaComponent *luaComp = itr->second->getComponent<LuaComponent>();
-				runScript(*itr->second);
+				LuaComponent *luaComp = entities[i]->getComponent<LuaComponent>();
+				runScript(*entities[i]);
 			}
 		}
 		else
 		{
 			// Find entities (scripts) associated with this message
-			auto itr = m_subscribedScripts.find(message->name);
+			auto itr = m_subscribedScripts.find(message->id);
 
 			if(itr != m_subscribedScripts.end())
 			{
@@ -102,15 +104,15 @@ namespace Saurobyte
 					LuaEnvironment::pushObject<Entity>(state, itr->second[i], "jl.Entity");
 
 					// Push event name
-					lua_pushstring(state, message->name.c_str());
+					lua_pushstring(state, message->id.getName());
 					int argCount = 2;
 
 					// Push event args, depending on event
-					if(message->name == "KeyDown" || message->name == "KeyUp")
+					if(message->id == "KeyDown" || message->id == "KeyUp")
 					{
 						if(message->isType<SDL_Event>())
 						{
-							const SDL_Event& sdlEvent = static_cast<MessageData<SDL_Event>*>(message)->data;
+							const SDL_Event &sdlEvent = message->read<SDL_Event>();
 							argCount += m_luaEnv.pushArgs(
 								std::string(SDL_GetScancodeName(sdlEvent.key.keysym.scancode)),
 								static_cast<bool>(sdlEvent.key.repeat));
@@ -120,8 +122,7 @@ namespace Saurobyte
 
 					else if(message->isType<std::string>())
 					{
-						std::string strData = static_cast<MessageData<std::string>*>(message)->data;
-						lua_pushstring(state, strData.c_str());
+						lua_pushstring(state, message->read<std::string>().c_str());
 						++argCount;
 					}
 
@@ -175,20 +176,28 @@ namespace Saurobyte
 	void LuaSystem::postProcess()
 	{
 	}
-	void LuaSystem::onAttach(Entity &entity)
+	void LuaSystem::onEntitiesAttached(const ArrayView<Entity*> &entities)
 	{
 		LuaEnvironment &env = engine->getLua();
 
-		LuaComponent *luaComp = entity.getComponent<LuaComponent>();
-		luaComp->sandBox = env.createSandbox(
-			{
-				"os.execute"
-			});
+		// All sandboxes of the batch share the same restrictions
+		const std::vector<std::string> disabledFunctions =
+		{
+			"os.execute"
+		};
 
-		env.pushObject<Entity*>(&entity, "Saurobyte_Entity");
-		env.writeGlobal("entity", luaComp->sandBox);
+		for(std::size_t i = 0; i < entities.size(); i++)
+		{
+			Entity &entity = *entities[i];
 
-		env.runScript(luaComp->luaFile, luaComp->sandBox);
+			LuaComponent *luaComp = entity.getComponent<LuaComponent>();
+			luaComp->sandBox = env.createSandbox(disabledFunctions);
+
+			LuaEnv_Entity::pushEntity(env, entity);
+			env.writeGlobal("entity", luaComp->sandBox);
+
+			env.runScript(luaComp->luaFile, luaComp->sandBox);
+		}
 	}
 	void LuaSystem::onDetach(Entity &entity)
 	{
@@ -264,29 +273,29 @@ namespace Saurobyte
 	}
 
 
-	void LuaSystem::subscribeEntity(Entity &entity, const std::string &eventName)
+	void LuaSystem::subscribeEntity(Entity &entity, const MessageID &eventID)
 	{
 		// Subscribe the LuaSystem to the specified event, and tell that the
 		// entity that's related to this script is interested in such events.
 		LuaComponent *comp = entity.getComponent<LuaComponent>();
 
-		if(comp->subscribedEvents.find(eventName) == comp->subscribedEvents.end())
+		if(comp->subscribedEvents.find(eventID) == comp->subscribedEvents.end())
 		{
-			subscribe(eventName);
-			comp->subscribedEvents.insert(eventName);
-			m_subscribedScripts[eventName].push_back(&entity);
+			subscribe(eventID);
+			comp->subscribedEvents.insert(eventID);
+			m_subscribedScripts[eventID].push_back(&entity);
 		}
 
 	}
-	void LuaSystem::unsubscribeEntity(Entity &entity, const std::string &eventName)
+	void LuaSystem::unsubscribeEntity(Entity &entity, const MessageID &eventID)
 	{
-		std::vector<Entity*>& scripts = m_subscribedScripts[eventName];
+		std::vector<Entity*>& scripts = m_subscribedScripts[eventID];
 		for(std::size_t i = 0; i < scripts.size(); i++)
 		{
 			if(scripts[i] == &entity)
 			{
 				LuaComponent *comp = entity.getComponent<LuaComponent>();
-				auto itr = comp->subscribedEvents.find(eventName);
+				auto itr = comp->subscribedEvents.find(eventID);
 				if(itr != comp->subscribedEvents.end())
 					comp->subscribedEvents.erase(itr);
 
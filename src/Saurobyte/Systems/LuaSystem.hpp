@@ -28,6 +28,8 @@ IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #define SAUROBYTE_LUASYSTEM_HPP
 
 #include <string>
+#include <unordered_map>
+#include <vector>
 #include <lua.hpp>
 #include <SDL2/SDL.h>
 #include <Saurobyte/System.hpp>
@@ -102,7 +104,7 @@ namespace Saurobyte
 
 
 		// Scripts subscribed to events
-		std::unordered_map<std::string, std::vector<Entity*> > m_subscribedScripts;
+		std::unordered_map<MessageID, std::vector<Entity*> > m_subscribedScripts;
 
 		void runScript(Entity &entity);
 
@@ -112,15 +114,15 @@ namespace Saurobyte
 		~LuaSystem();
 
 		// Subscribes the entity to the specified event, so its scripts receives them
-		void subscribeEntity(Entity &entity, const std::string &eventName);
-		void unsubscribeEntity(Entity &entity, const std::string &eventName);
+		void subscribeEntity(Entity &entity, const MessageID &eventID);
+		void unsubscribeEntity(Entity &entity, const MessageID &eventID);
 
 		virtual void onMessage(Message *message);
 
 		virtual void processEntity(Entity &entity);
 		virtual void postProcess();
 
-		virtual void onAttach(Entity &entity);
+		virtual void onEntitiesAttached(const ArrayView<Entity*> &entities);
 		virtual void onDetach(Entity &entity);
 		virtual void onKill(Entity &entity);
 		virtual void onClear();
@@ -0,0 +1,184 @@
+/*
+
+	The MIT License (MIT)
+
+	Copyright (c) 2014 by Jakob Larsson
+
+	Permission is hereby granted, free of charge, to any person obtaining 
+	a copy of this software and associated documentation files (the "Software"), 
+	to deal in the Software without restriction, including without limitation the 
+	rights to use, copy, modify, merge, publish, distribute, sublicense, and/or 
+	sell copies of the Software, and to permit persons to whom the Software is 
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in 
+	all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+	IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+#include <Saurobyte/ThreadPool.hpp>
+
+namespace Saurobyte
+{
+	namespace
+	{
+		// Pool and queue index of the calling thread, set for worker threads only
+		thread_local const ThreadPool *currentPool = nullptr;
+		thread_local std::size_t currentThreadIndex = 0;
+	};
+
+	ThreadPool::ThreadPool(std::size_t workerCount)
+		:
+		m_queuedTasks(0),
+		m_stopping(false)
+	{
+		for(std::size_t i = 0; i < workerCount + 1; i++)
+			m_queues.push_back(std::unique_ptr<TaskQueue>(new TaskQueue()));
+
+		for(std::size_t i = 0; i < workerCount; i++)
+			m_workers.push_back(std::thread(&ThreadPool::runWorker, this, i + 1));
+	}
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_sleepMutex);
+			m_stopping = true;
+		}
+		m_taskAvailable.notify_all();
+
+		for(std::size_t i = 0; i < m_workers.size(); i++)
+			m_workers[i].join();
+	}
+
+	void ThreadPool::push(Task task)
+	{
+		push(std::move(task), m_defaultGroup);
+	}
+	void ThreadPool::push(Task task, TaskGroup &group)
+	{
+		++group.m_unfinishedTasks;
+
+		TaskQueue &queue = *m_queues[getThreadIndex()];
+		{
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			queue.tasks.push_back({std::move(task), &group});
+		}
+		++m_queuedTasks;
+
+		// Threads blocked in wait help out with queued tasks too, so wake one of each
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_taskAvailable.notify_one();
+		m_taskFinished.notify_one();
+	}
+
+	void ThreadPool::wait()
+	{
+		wait(m_defaultGroup);
+	}
+	void ThreadPool::wait(TaskGroup &group)
+	{
+		std::size_t threadIndex = getThreadIndex();
+		QueuedTask task;
+
+		while(group.m_unfinishedTasks > 0)
+		{
+			// Help out rather than idle, even with tasks of other groups
+			if(popTask(threadIndex, task))
+				runTask(task);
+			else
+			{
+				std::unique_lock<std::mutex> lock(m_sleepMutex);
+				m_taskFinished.wait(lock, [this, &group] ()
+				{
+					return group.m_unfinishedTasks == 0 || m_queuedTasks > 0;
+				});
+			}
+		}
+	}
+
+	void ThreadPool::runWorker(std::size_t threadIndex)
+	{
+		currentPool = this;
+		currentThreadIndex = threadIndex;
+
+		QueuedTask task;
+		while(true)
+		{
+			if(popTask(threadIndex, task))
+			{
+				runTask(task);
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock(m_sleepMutex);
+			m_taskAvailable.wait(lock, [this] () { return m_stopping || m_queuedTasks > 0; });
+
+			if(m_stopping && m_queuedTasks == 0)
+				return;
+		}
+	}
+	bool ThreadPool::popTask(std::size_t threadIndex, QueuedTask &task)
+	{
+		if(m_queuedTasks == 0)
+			return false;
+
+		// Newest task of our own queue first, it's likely to still be in cache
+		{
+			TaskQueue &queue = *m_queues[threadIndex];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			if(!queue.tasks.empty())
+			{
+				task = std::move(queue.tasks.back());
+				queue.tasks.pop_back();
+				--m_queuedTasks;
+				return true;
+			}
+		}
+
+		// Steal the oldest task of another queue, those tend to be the largest
+		for(std::size_t i = 1; i < m_queues.size(); i++)
+		{
+			TaskQueue &queue = *m_queues[(threadIndex + i) % m_queues.size()];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			if(!queue.tasks.empty())
+			{
+				task = std::move(queue.tasks.front());
+				queue.tasks.pop_front();
+				--m_queuedTasks;
+				return true;
+			}
+		}
+
+		return false;
+	}
+	void ThreadPool::runTask(QueuedTask &task)
+	{
+		task.task();
+		task.task = nullptr;
+
+		if(--task.group->m_unfinishedTasks == 0)
+		{
+			std::lock_guard<std::mutex> lock(m_sleepMutex);
+			m_taskFinished.notify_all();
+		}
+	}
+
+	std::size_t ThreadPool::getWorkerCount() const
+	{
+		return m_workers.size();
+	}
+	std::size_t ThreadPool::getThreadCount() const
+	{
+		return m_queues.size();
+	}
+	std::size_t ThreadPool::getThreadIndex() const
+	{
+		return currentPool == this ? currentThreadIndex : 0;
+	}
+};
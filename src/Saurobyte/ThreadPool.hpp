@@ -0,0 +1,162 @@
+/*
+
+	The MIT License (MIT)
+
+	Copyright (c) 2014 by Jakob Larsson
+
+	Permission is hereby granted, free of charge, to any person obtaining 
+	a copy of this software and associated documentation files (the "Software"), 
+	to deal in the Software without restriction, including without limitation the 
+	rights to use, copy, modify, merge, publish, distribute, sublicense, and/or 
+	sell copies of the Software, and to permit persons to whom the Software is 
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in 
+	all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+	IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+#ifndef SAUROBYTE_THREADPOOL_HPP
+#define SAUROBYTE_THREADPOOL_HPP
+
+#include <Saurobyte/NonCopyable.hpp>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <algorithm>
+
+namespace Saurobyte
+{
+	/*
+		ThreadPool
+
+		Fixed set of worker threads executing submitted tasks. Every thread
+		has its own task queue: tasks pushed from a worker go to the queue of
+		that worker and are run newest first, while idle threads steal the
+		oldest tasks of other queues. Threads waiting for tasks to finish help
+		out with executing them, so a pool with N workers runs tasks on N+1
+		threads.
+
+		Tasks are tracked in groups, allowing tasks to push and wait for their
+		own subtasks without waiting for unrelated work.
+
+	*/
+	class ThreadPool : public NonCopyable
+	{
+	public:
+
+		typedef std::function<void()> Task;
+
+		// Counter of unfinished tasks that can be waited on
+		class TaskGroup : public NonCopyable
+		{
+		public:
+			TaskGroup() : m_unfinishedTasks(0) {};
+
+		private:
+			friend class ThreadPool;
+			std::atomic<std::size_t> m_unfinishedTasks;
+		};
+
+		/**
+		 * Starts the worker threads of the pool
+		 * @param workerCount Amount of worker threads, 0 makes wait() run all tasks on the calling thread
+		 */
+		explicit ThreadPool(std::size_t workerCount);
+		~ThreadPool();
+
+		/**
+		 * Queues a task for execution by any of the threads of the pool
+		 * @param task  The task to execute
+		 * @param group The group tracking the task, the default group of the pool is used if left out
+		 */
+		void push(Task task);
+		void push(Task task, TaskGroup &group);
+
+		/**
+		 * Executes queued tasks on the calling thread until all tasks of a group have finished
+		 * @param group The group to wait for, the default group of the pool is used if left out
+		 */
+		void wait();
+		void wait(TaskGroup &group);
+
+		/**
+		 * Splits the range [0, count) into chunks and processes them on all threads of the pool, returning
+		 * once every chunk is done. The chunk function is called as func(begin, end, threadIndex).
+		 * @param count     Amount of items to process
+		 * @param chunkSize Amount of items in a chunk
+		 * @param func      Function processing a chunk
+		 */
+		template<typename TFunc> void parallelFor(std::size_t count, std::size_t chunkSize, TFunc func)
+		{
+			TaskGroup group;
+			chunkSize = std::max<std::size_t>(chunkSize, 1);
+
+			for(std::size_t begin = 0; begin < count; begin += chunkSize)
+			{
+				std::size_t end = std::min(count, begin + chunkSize);
+				push([this, begin, end, &func] () { func(begin, end, getThreadIndex()); }, group);
+			}
+
+			wait(group);
+		};
+
+		std::size_t getWorkerCount() const;
+
+		/**
+		 * Returns the amount of threads that may run tasks, that is the workers plus the waiting thread
+		 */
+		std::size_t getThreadCount() const;
+
+		/**
+		 * Returns the index of the calling thread within the pool, in the range [0, getThreadCount()).
+		 * Workers get indices starting at 1, any other thread is regarded as index 0.
+		 */
+		std::size_t getThreadIndex() const;
+
+	private:
+
+		struct QueuedTask
+		{
+			Task task;
+			TaskGroup *group;
+		};
+		struct TaskQueue
+		{
+			std::mutex mutex;
+			std::deque<QueuedTask> tasks;
+		};
+
+		// One queue per thread, the first one belongs to threads outside of the pool
+		std::vector<std::unique_ptr<TaskQueue> > m_queues;
+		std::vector<std::thread> m_workers;
+
+		TaskGroup m_defaultGroup;
+		std::atomic<std::size_t> m_queuedTasks;
+		bool m_stopping;
+
+		// Sleeping threads wait for these, the mutex guarding against lost wakeups
+		std::mutex m_sleepMutex;
+		std::condition_variable m_taskAvailable;
+		std::condition_variable m_taskFinished;
+
+		void runWorker(std::size_t threadIndex);
+
+		// Pops a task from the queue of the thread, or steals one from another queue
+		bool popTask(std::size_t threadIndex, QueuedTask &task);
+		void runTask(QueuedTask &task);
+	};
+};
+
+#endif
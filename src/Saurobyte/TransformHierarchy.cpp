@@ -0,0 +1,268 @@
+/*
+
+	The MIT License (MIT)
+
+	Copyright (c) 2014 by Jakob Larsson
+
+	Permission is hereby granted, free of charge, to any person obtaining 
+	a copy of this software and associated documentation files (the "Software"), 
+	to deal in the Software without restriction, including without limitation the 
+	rights to use, copy, modify, merge, publish, distribute, sublicense, and/or 
+	sell copies of the Software, and to permit persons to whom the Software is 
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in 
+	all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+	IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+#include <Saurobyte/TransformHierarchy.hpp>
+#include <Saurobyte/World.hpp>
+#include <Saurobyte/Components/TransformComponent.hpp>
+#include <Saurobyte/CommandBuffer.hpp>
+#include <Saurobyte/Logger.hpp>
+#include <algorithm>
+#include <unordered_set>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+	#include <xmmintrin.h>
+	#define SAUROBYTE_SSE_TRANSFORMS
+#endif
+
+namespace Saurobyte
+{
+	namespace
+	{
+		// Multiplies two column major matrices, 'result' must not be 'lhs'
+		void multiplyTransforms(const Matrix4 &lhs, const Matrix4 &rhs, Matrix4 &result)
+		{
+#ifdef SAUROBYTE_SSE_TRANSFORMS
+			const float *left = &lhs[0][0];
+			const float *right = &rhs[0][0];
+			float *out = &result[0][0];
+
+			__m128 column0 = _mm_loadu_ps(left);
+			__m128 column1 = _mm_loadu_ps(left + 4);
+			__m128 column2 = _mm_loadu_ps(left + 8);
+			__m128 column3 = _mm_loadu_ps(left + 12);
+
+			// Every column of the result is the columns of 'lhs' weighted by a column of 'rhs'
+			for(int i = 0; i < 4; i++)
+			{
+				const float *weights = right + i * 4;
+
+				__m128 column = _mm_mul_ps(column0, _mm_set1_ps(weights[0]));
+				column = _mm_add_ps(column, _mm_mul_ps(column1, _mm_set1_ps(weights[1])));
+				column = _mm_add_ps(column, _mm_mul_ps(column2, _mm_set1_ps(weights[2])));
+				column = _mm_add_ps(column, _mm_mul_ps(column3, _mm_set1_ps(weights[3])));
+
+				_mm_storeu_ps(out + i * 4, column);
+			}
+#else
+			result = lhs * rhs;
+#endif
+		}
+	};
+
+	const std::size_t TransformHierarchy::NoParent = static_cast<std::size_t>(-1);
+
+	TransformHierarchy::TransformHierarchy(World *world)
+		:
+		m_isSorted(true),
+		m_world(world)
+	{
+
+	}
+
+	void TransformHierarchy::setParent(Entity &child, Entity *parent)
+	{
+		CommandBuffer *commands = CommandBuffer::getActive();
+		if(commands != nullptr)
+		{
+			commands->setParent(child, parent);
+			return;
+		}
+
+		TransformComponent *transform = child.getComponent<TransformComponent>();
+		if(transform == nullptr)
+		{
+			SAUROBYTE_WARNING_LOG("Entity ", child.getID(), " needs a TransformComponent to have a parent");
+			return;
+		}
+
+		if(parent == nullptr)
+		{
+			unlink(child);
+			return;
+		}
+
+		if(parent->getComponent<TransformComponent>() == nullptr)
+		{
+			SAUROBYTE_WARNING_LOG("Entity ", parent->getID(), " needs a TransformComponent to have children");
+			return;
+		}
+
+		// Entities can't end up below themselves
+		for(Entity *ancestor = parent; ancestor != nullptr; ancestor = getParent(*ancestor))
+		{
+			if(ancestor == &child)
+			{
+				SAUROBYTE_WARNING_LOG("Entity ", parent->getID(), " is a descendant of entity ", child.getID(), " and can't be its parent");
+				return;
+			}
+		}
+
+		m_links[child.getID()] = { child.getHandle(), parent->getHandle() };
+		transform->m_hasParent = true;
+		transform->m_isTransformDirty = true;
+
+		// The world transform becomes relative to the parent
+		transform->markChanged();
+		m_isSorted = false;
+	}
+	Entity* TransformHierarchy::getParent(const Entity &child)
+	{
+		auto itr = m_links.find(child.getID());
+		if(itr == m_links.end() || itr->second.child != child.getHandle())
+			return nullptr;
+
+		return m_world->getEntityPool().getEntity(itr->second.parent);
+	}
+	void TransformHierarchy::unlink(Entity &child)
+	{
+		auto itr = m_links.find(child.getID());
+		if(itr == m_links.end())
+			return;
+
+		m_links.erase(itr);
+		m_isSorted = false;
+
+		TransformComponent *transform = child.getComponent<TransformComponent>();
+		if(transform != nullptr && transform->m_hasParent)
+		{
+			transform->m_hasParent = false;
+			transform->m_modelTransform = transform->m_localTransform;
+			transform->markChanged();
+		}
+	}
+
+	void TransformHierarchy::update()
+	{
+		// Structural changes are applied all at once, recomputing every transform
+		bool isResorted = !m_isSorted;
+		if(isResorted)
+			sort();
+
+		EntityPool &entityPool = m_world->getEntityPool();
+		for(std::size_t i = 0; i < m_nodes.size(); i++)
+		{
+			const Node &node = m_nodes[i];
+			Entity *entity = entityPool.getEntity(node.entity);
+			TransformComponent *transform = entity == nullptr ? nullptr : entity->getComponent<TransformComponent>();
+
+			// Entities that are gone are dropped by the next update, which detaches their children
+			if(transform == nullptr)
+			{
+				m_dirtyNodes[i] = false;
+				m_isSorted = false;
+				continue;
+			}
+
+			// Parents come first, so they are up to date by the time their children are reached
+			bool parentChanged = node.parent != NoParent && m_dirtyNodes[node.parent];
+			m_dirtyNodes[i] = isResorted || parentChanged || transform->m_isTransformDirty;
+			if(!m_dirtyNodes[i])
+				continue;
+
+			if(node.parent == NoParent)
+				m_worldTransforms[i] = transform->m_localTransform;
+			else
+				multiplyTransforms(m_worldTransforms[node.parent], transform->m_localTransform, m_worldTransforms[i]);
+
+			transform->m_modelTransform = m_worldTransforms[i];
+			transform->m_isTransformDirty = false;
+
+			// Children move along with their parents
+			if(parentChanged)
+				transform->markChanged();
+		}
+	}
+	void TransformHierarchy::sort()
+	{
+		EntityPool &entityPool = m_world->getEntityPool();
+
+		// Drop links of children that are gone, and detach the children of parents that are gone
+		for(auto itr = m_links.begin(); itr != m_links.end();)
+		{
+			Entity *child = entityPool.getEntity(itr->second.child);
+			Entity *parent = entityPool.getEntity(itr->second.parent);
+			TransformComponent *transform = child == nullptr ? nullptr : child->getComponent<TransformComponent>();
+
+			if(transform != nullptr && parent != nullptr && parent->getComponent<TransformComponent>() != nullptr)
+			{
+				// Components may have been replaced since the link was made
+				transform->m_hasParent = true;
+				itr++;
+				continue;
+			}
+
+			if(transform != nullptr)
+			{
+				transform->m_hasParent = false;
+				transform->m_modelTransform = transform->m_localTransform;
+				transform->markChanged();
+			}
+
+			itr = m_links.erase(itr);
+		}
+
+		// Order children by depth, with the parents that have no parents themselves at the front
+		std::vector<std::pair<std::size_t, EntityHandle> > order;
+		std::unordered_set<EntityID> roots;
+		for(auto itr = m_links.begin(); itr != m_links.end(); itr++)
+		{
+			std::size_t depth = 0;
+			for(auto parent = itr; parent != m_links.end(); parent = m_links.find(parent->second.parent.id))
+				depth++;
+
+			order.push_back(std::make_pair(depth, itr->second.child));
+
+			const EntityHandle &parent = itr->second.parent;
+			if(m_links.find(parent.id) == m_links.end() && roots.insert(parent.id).second)
+				order.push_back(std::make_pair(0, parent));
+		}
+		std::sort(order.begin(), order.end(),
+			[] (const std::pair<std::size_t, EntityHandle> &lhs, const std::pair<std::size_t, EntityHandle> &rhs)
+			{
+				return lhs.first != rhs.first ? lhs.first < rhs.first : lhs.second.id < rhs.second.id;
+			});
+
+		std::unordered_map<EntityID, std::size_t> indices;
+		m_nodes.clear();
+		for(std::size_t i = 0; i < order.size(); i++)
+		{
+			const EntityHandle &entity = order[i].second;
+			indices[entity.id] = i;
+
+			auto link = m_links.find(entity.id);
+			Node node = { entity, link == m_links.end() ? NoParent : indices[link->second.parent.id] };
+			m_nodes.push_back(node);
+		}
+
+		m_worldTransforms.resize(m_nodes.size());
+		m_dirtyNodes.resize(m_nodes.size());
+		m_isSorted = true;
+	}
+
+	std::size_t TransformHierarchy::getSize() const
+	{
+		return m_nodes.size();
+	}
+};
@@ -0,0 +1,118 @@
+/*
+
+	The MIT License (MIT)
+
+	Copyright (c) 2014 by Jakob Larsson
+
+	Permission is hereby granted, free of charge, to any person obtaining 
+	a copy of this software and associated documentation files (the "Software"), 
+	to deal in the Software without restriction, including without limitation the 
+	rights to use, copy, modify, merge, publish, distribute, sublicense, and/or 
+	sell copies of the Software, and to permit persons to whom the Software is 
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in 
+	all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+	IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+#ifndef SAUROBYTE_TRANSFORM_HIERARCHY_HPP
+#define SAUROBYTE_TRANSFORM_HIERARCHY_HPP
+
+#include <Saurobyte/IdentifierTypes.hpp>
+#include <Saurobyte/NonCopyable.hpp>
+#include <Saurobyte/Math.hpp>
+#include <unordered_map>
+#include <vector>
+
+namespace Saurobyte
+{
+	class World;
+	class Entity;
+
+	/*
+		TransformHierarchy
+
+		Parent links between entities with a TransformComponent, making the
+		transform of a child relative to the transform of its parent (weapons
+		held by characters, turrets on vehicles):
+
+			world.getTransformHierarchy().setParent(turret, &vehicle);
+
+		Linked entities are kept in a flat array sorted by depth, so parents
+		always come before their children. World transforms are propagated in
+		a single linear pass over the array, only recomputing the subtrees of
+		transforms that changed. Entities without parents or children aren't
+		part of the hierarchy at all, their world transform is their local one.
+
+	*/
+	class TransformHierarchy : public NonCopyable
+	{
+	public:
+
+		explicit TransformHierarchy(World *world);
+
+		/**
+		 * Attaches an entity to a parent, both need a TransformComponent. Killing the parent or removing its
+		 * TransformComponent detaches its children. Recorded into the active CommandBuffer, if any.
+		 * @param child  The entity to attach
+		 * @param parent The new parent of the entity, nullptr to detach it from its current parent
+		 */
+		void setParent(Entity &child, Entity *parent);
+		/**
+		 * Returns the parent of the entity, nullptr if it has none
+		 */
+		Entity* getParent(const Entity &child);
+
+		/**
+		 * Recomputes the world transforms (see TransformComponent::getTransform) of entities whose own or parent
+		 * transforms changed. Called by World::frame before the systems run, call it again when a system needs
+		 * the transforms of children moved earlier in the same frame.
+		 */
+		void update();
+
+		// Amount of entities in the hierarchy, both parents and children
+		std::size_t getSize() const;
+
+	private:
+
+		static const std::size_t NoParent;
+
+		struct Link
+		{
+			EntityHandle child;
+			EntityHandle parent;
+		};
+		// Parent of every child, by EntityID of the child
+		std::unordered_map<EntityID, Link> m_links;
+
+		// Linked entities sorted by depth, with the index of their parent in the same arrays
+		struct Node
+		{
+			EntityHandle entity;
+			std::size_t parent;
+		};
+		std::vector<Node> m_nodes;
+		std::vector<Matrix4> m_worldTransforms;
+		std::vector<unsigned char> m_dirtyNodes;
+
+		// Whether or not the nodes reflect the links, sorting is deferred until the next update
+		bool m_isSorted;
+
+		// Rebuilds the nodes from the links, dropping links to entities that are gone
+		void sort();
+		// Removes the link of a child, its world transform becomes its local transform
+		void unlink(Entity &child);
+
+		World *m_world;
+	};
+};
+
+#endif
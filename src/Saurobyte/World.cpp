@@ -0,0 +1,189 @@
+/*
+
+	The MIT License (MIT)
+
+	Copyright (c) 2014 by Jakob Larsson
+
+	Permission is hereby granted, free of charge, to any person obtaining 
+	a copy of this software and associated documentation files (the "Software"), 
+	to deal in the Software without restriction, including without limitation the 
+	rights to use, copy, modify, merge, publish, distribute, sublicense, and/or 
+	sell copies of the Software, and to permit persons to whom the Software is 
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in 
+	all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+	IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+#include <Saurobyte/World.hpp>
+#include <Saurobyte/Message.hpp>
+
+namespace Saurobyte
+{
+	World::Scope::Scope(World &world)
+		:
+		m_previousVersion(BaseComponent::setVersionCounter(&world.m_changeVersion))
+	{
+
+	}
+	World::Scope::~Scope()
+	{
+		BaseComponent::setVersionCounter(m_previousVersion);
+	}
+
+	World::World(std::size_t workerCount)
+		:
+		m_messageCentral(),
+		m_entityPool(this),
+		m_systemPool(this, workerCount),
+		m_scenePool(this),
+		m_transformHierarchy(this),
+		m_spatialGrid(this, 16.f),
+		m_delta(0),
+		m_changeVersion(1)
+	{
+		makeCurrent();
+	}
+	World::~World()
+	{
+		// Don't leave the thread stamping components with a destroyed counter
+		unsigned int *current = BaseComponent::setVersionCounter(nullptr);
+		if(current != &m_changeVersion)
+			BaseComponent::setVersionCounter(current);
+	}
+
+	void World::makeCurrent()
+	{
+		BaseComponent::setVersionCounter(&m_changeVersion);
+	}
+	void World::frame(float delta)
+	{
+		makeCurrent();
+		m_delta = delta;
+
+		// Send messages posted from other threads and queued during the previous frame, while the entities
+		// they concern are still alive
+		m_messageCentral.dispatchPostedMessages();
+		m_messageCentral.dispatchQueuedMessages();
+
+		// Process frame start entity cleanup
+		m_scenePool.frameCleanup();
+		m_entityPool.frameCleanup();
+		m_transformHierarchy.update();
+		m_spatialGrid.update();
+
+		// Process the systems and their entities
+		m_systemPool.processSystems();
+	}
+
+	Entity& World::createEntity()
+	{
+		return m_entityPool.createEntity();
+	}
+	Entity& World::createEntity(const std::string &templateName)
+	{
+		return m_entityPool.createEntity(templateName);
+	}
+	Scene& World::createScene(const std::string &name)
+	{
+		return m_scenePool.createScene(name);
+	}
+
+	void World::changeScene(const std::string &sceneName)
+	{
+		m_scenePool.changeScene(sceneName);
+	}
+	Scene* World::getActiveScene()
+	{
+		return m_scenePool.getActiveScene();
+	}
+
+	void World::sendMessage(const Message &message)
+	{
+		m_messageCentral.sendMessage(message);
+	}
+	void World::sendMessage(const MessageID &messageID, Entity *entity)
+	{
+		m_messageCentral.sendMessage(Message(messageID, entity));
+	}
+	void World::queueMessage(const MessageID &messageID, Entity *entity)
+	{
+		m_messageCentral.queueMessage(messageID, entity);
+	}
+	bool World::postMessage(const MessageID &messageID, Entity *entity)
+	{
+		return m_messageCentral.postMessage(messageID, entity);
+	}
+
+	void World::sendMessageInRegion(const MessageID &messageID, const BoundingBox &region)
+	{
+		Message message(messageID);
+		sendMessageInRegion(message, region);
+	}
+	void World::sendMessageInRegion(Message &message, const BoundingBox &region)
+	{
+		// Subscribers may send region messages themselves, which then get their own vector
+		std::vector<Entity*> entities;
+		entities.swap(m_regionEntities);
+
+		m_spatialGrid.query(region, entities);
+		m_messageCentral.sendMessage(message, entities);
+
+		entities.clear();
+		m_regionEntities.swap(entities);
+	}
+	void World::sendMessageInRadius(const MessageID &messageID, const Vector3f &center, float radius)
+	{
+		Message message(messageID);
+		sendMessageInRadius(message, center, radius);
+	}
+	void World::sendMessageInRadius(Message &message, const Vector3f &center, float radius)
+	{
+		std::vector<Entity*> entities;
+		entities.swap(m_regionEntities);
+
+		m_spatialGrid.query(center, radius, entities);
+		m_messageCentral.sendMessage(message, entities);
+
+		entities.clear();
+		m_regionEntities.swap(entities);
+	}
+
+	float World::getDelta() const
+	{
+		return m_delta;
+	}
+
+	EntityPool& World::getEntityPool()
+	{
+		return m_entityPool;
+	}
+	SystemPool& World::getSystemPool()
+	{
+		return m_systemPool;
+	}
+	ScenePool& World::getScenePool()
+	{
+		return m_scenePool;
+	}
+	MessageCentral& World::getMessageCentral()
+	{
+		return m_messageCentral;
+	}
+	TransformHierarchy& World::getTransformHierarchy()
+	{
+		return m_transformHierarchy;
+	}
+	SpatialGrid& World::getSpatialGrid()
+	{
+		return m_spatialGrid;
+	}
+};
@@ -0,0 +1,221 @@
+/*
+
+	The MIT License (MIT)
+
+	Copyright (c) 2014 by Jakob Larsson
+
+	Permission is hereby granted, free of charge, to any person obtaining 
+	a copy of this software and associated documentation files (the "Software"), 
+	to deal in the Software without restriction, including without limitation the 
+	rights to use, copy, modify, merge, publish, distribute, sublicense, and/or 
+	sell copies of the Software, and to permit persons to whom the Software is 
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in 
+	all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+	IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+#ifndef SAUROBYTE_WORLD_HPP
+#define SAUROBYTE_WORLD_HPP
+
+#include <Saurobyte/MessageCentral.hpp>
+#include <Saurobyte/EntityPool.hpp>
+#include <Saurobyte/SystemPool.hpp>
+#include <Saurobyte/ScenePool.hpp>
+#include <Saurobyte/TransformHierarchy.hpp>
+#include <Saurobyte/SpatialGrid.hpp>
+#include <Saurobyte/ApiDefines.hpp>
+#include <Saurobyte/NonCopyable.hpp>
+#include <string>
+#include <vector>
+
+namespace Saurobyte
+{
+	/*
+		World
+
+		Self-contained simulation owning its own entities, systems, scenes and
+		messages. The Engine runs a single world alongside its window, but any
+		amount of headless worlds may exist, and worlds may tick concurrently on
+		different threads as long as each world is only used by one thread at a
+		time. Component types are registered once per process and shared by all
+		worlds, everything else (including entity templates) is per world.
+		Worlds run their systems on the ticking thread unless given worker
+		threads, so secondary worlds don't each spawn a full thread pool.
+
+			Saurobyte::World world;
+			world.getSystemPool().addSystem(new PhysicsSystem(&world));
+			world.createScene("Match");
+			world.changeScene("Match");
+
+			while(!matchOver)
+				world.frame(1.0f / 60);
+
+	*/
+	class SAUROBYTE_API World : public NonCopyable
+	{
+	public:
+
+		/*
+			Scope
+
+			Temporarily makes a world current on the calling thread, see makeCurrent.
+			Used for worlds sharing a thread, and by the SystemPool on its workers.
+
+		*/
+		class SAUROBYTE_API Scope : public NonCopyable
+		{
+		public:
+
+			explicit Scope(World &world);
+			~Scope();
+
+		private:
+
+			unsigned int *m_previousVersion;
+		};
+
+		/**
+		 * Creates an empty world, which becomes current on the calling thread
+		 * @param workerCount Amount of worker threads the world's systems may run on, 0 runs
+		 * every system on the ticking thread
+		 */
+		explicit World(std::size_t workerCount = 0);
+		~World();
+
+		/**
+		 * Makes the world current on the calling thread, so components changed on the thread are stamped with the
+		 * change versions of this world (see BaseComponent::getVersion). Worlds become current when created and
+		 * when ticked, so this is only needed when changing components of several worlds on the same thread.
+		 * A world must be destroyed on the thread it was last current on.
+		 */
+		void makeCurrent();
+
+		/**
+		 * Advances the world by a frame, sending the messages posted and queued since the previous frame, applying
+		 * pending scene and entity changes and updating the transform hierarchy before running the systems.
+		 * The world becomes current on the calling thread, see makeCurrent.
+		 * @param delta Seconds passed since the previous frame
+		 */
+		void frame(float delta);
+
+		// Creating entities and scenes
+		Entity& createEntity();
+		Entity& createEntity(const std::string &templateName);
+		Scene& createScene(const std::string &name);
+
+		// Iterating entities by their components, see EntityView
+		template<typename... TTypes> EntityView<TTypes...> view()
+		{
+			return m_entityPool.view<TTypes...>();
+		};
+
+		// Scene managing
+		void changeScene(const std::string &sceneName);
+		Scene* getActiveScene();
+
+		// Message sending
+		void sendMessage(const Message &message);
+		void sendMessage(const MessageID &messageID, Entity *entity = nullptr);
+		template<typename TType> void sendMessage(const MessageID &messageID, TType data, Entity *entity = nullptr)
+		{
+			sendMessage(MessageData<TType>(messageID, std::move(data), entity));
+		};
+
+		// Queued message sending, queued messages are sent at the start of the next frame
+		void queueMessage(const MessageID &messageID, Entity *entity = nullptr);
+		template<typename TType> void queueMessage(const MessageID &messageID, TType data, Entity *entity = nullptr)
+		{
+			m_messageCentral.queueMessage<TType>(messageID, std::move(data), entity);
+		};
+
+		// Posting messages from any thread, posted messages are sent at the start of the next frame
+		bool postMessage(const MessageID &messageID, Entity *entity = nullptr);
+		template<typename TType> bool postMessage(const MessageID &messageID, TType data, Entity *entity = nullptr)
+		{
+			return m_messageCentral.postMessage<TType>(messageID, std::move(data), entity);
+		};
+
+		/**
+		 * Sends a message once for every entity whose world position is within a region, with the entity set as
+		 * the entity of the message. Entities are found through the spatial grid, by their positions at the start
+		 * of the frame (see SpatialGrid::update), and subscribers are looked up once for all of them.
+		 * @param messageID The name of the message
+		 * @param region    The box the entities must be within
+		 */
+		void sendMessageInRegion(const MessageID &messageID, const BoundingBox &region);
+		void sendMessageInRegion(Message &message, const BoundingBox &region);
+		/**
+		 * Sends a message with data once for every entity whose world position is within a region
+		 * @param messageID The name of the message
+		 * @param region    The box the entities must be within
+		 * @param data      Data to be sent with the message
+		 */
+		template<typename TType> void sendMessageInRegion(const MessageID &messageID, const BoundingBox &region, TType data)
+		{
+			MessageData<TType> message(messageID, std::move(data));
+			sendMessageInRegion(message, region);
+		};
+		/**
+		 * Sends a message once for every entity whose world position is within a sphere, see sendMessageInRegion
+		 * @param messageID The name of the message
+		 * @param center    Center of the sphere
+		 * @param radius    Radius of the sphere
+		 */
+		void sendMessageInRadius(const MessageID &messageID, const Vector3f &center, float radius);
+		void sendMessageInRadius(Message &message, const Vector3f &center, float radius);
+		/**
+		 * Sends a message with data once for every entity whose world position is within a sphere
+		 * @param messageID The name of the message
+		 * @param center    Center of the sphere
+		 * @param radius    Radius of the sphere
+		 * @param data      Data to be sent with the message
+		 */
+		template<typename TType> void sendMessageInRadius(const MessageID &messageID, const Vector3f &center, float radius, TType data)
+		{
+			MessageData<TType> message(messageID, std::move(data));
+			sendMessageInRadius(message, center, radius);
+		};
+
+		/**
+		 * Returns the seconds passed during the current (or last) frame
+		 */
+		float getDelta() const;
+
+		EntityPool& getEntityPool();
+		SystemPool& getSystemPool();
+		ScenePool& getScenePool();
+		MessageCentral& getMessageCentral();
+		TransformHierarchy& getTransformHierarchy();
+		SpatialGrid& getSpatialGrid();
+
+	private:
+
+		// Declared first so the systems, which are message handlers, are destroyed before it
+		MessageCentral m_messageCentral;
+
+		EntityPool m_entityPool;
+		SystemPool m_systemPool;
+		ScenePool m_scenePool;
+		TransformHierarchy m_transformHierarchy;
+		SpatialGrid m_spatialGrid;
+
+		// Recipients of region sends, kept to reuse its memory
+		std::vector<Entity*> m_regionEntities;
+
+		float m_delta;
+
+		// Change version of the components of this world, see makeCurrent
+		unsigned int m_changeVersion;
+	};
+};
+
+#endif